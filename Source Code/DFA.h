@@ -1,10 +1,30 @@
 #pragma once
 
 #include "FiniteStateMachine.h"
+#include "DFAAccelerator.h"
 #include <assert.h>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <variant>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define FSM_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define FSM_PREFETCH(address) __builtin_prefetch((address))
+#else
+#define FSM_PREFETCH(address) ((void)(address))
+#endif
 
 namespace m0st4fa {
 
+	template <typename TransFuncT, typename InputT>
+	class DFAStreamMatcher;
+	class DFASerializer;
+
 	// DECLARATIONS
 	/**
 	* @brief A DFA that that can be used to match strings.
@@ -12,26 +32,234 @@ namespace m0st4fa {
 	*/
 	template <typename TransFuncT, typename InputT = std::string>
 	class DeterFiniteAutomatan: FiniteStateMachine<TransFuncT, InputT> {
+		// friends
+		friend class DFAStreamMatcher<TransFuncT, InputT>;
+		friend class DFASerializer;
+
 		// fields
+		/**
+		* The compiled form of the automaton is built by _compile(), or mapped from a file by DFASerializer::load().
+		* It never changes once built, so copies of the automaton share it; the fields below only view it.
+		* `m_Storage` keeps it alive, whichever of the two owns the memory.
+		*/
+		struct CompiledStorage {
+			std::variant<FSMDynamicTable<std::uint8_t>, FSMDynamicTable<std::uint16_t>, FSMDynamicTable<state_t>> classTable;
+			std::vector<state_t> stateIds;
+			std::vector<DFAAccelerator> accelerators;
+		};
+		std::shared_ptr<const void> m_Storage;
+
+		/**
+		* The transition function compressed over byte classes.
+		* Row `s` holds the next state of `s` for every class id.
+		* The entries are premultiplied: a state is stored as the offset of its row (`id * getClassCount()`).
+		* The table is validated when it is built or loaded, so stepping through it needs no bounds checks.
+		* The states are renumbered: the dead state keeps row 0 and the final states take the last rows,
+		* so a state is final exactly when it is not less than `m_FinalStart`.
+		* The accelerated states take the rows on both sides of `m_FinalStart`, so a state is accelerated exactly when it is in [m_AccelStart, m_AccelEnd).
+		* The entries are stored in the narrowest of 1, 2 or 4 bytes that holds the largest premultiplied state (see _with_entry_type()).
+		*/
+		ByteClassMap m_ByteClasses{};
+		FSMPackedTableView m_ClassTable;
+		std::span<const state_t> m_StateIds; // the original id of every row
+		state_t m_StartState = 0;
+		state_t m_FinalStart = 0;
+		state_t m_AccelStart = 0;
+		state_t m_AccelEnd = 0;
+		std::span<const DFAAccelerator> m_Accelerators; // one for every accelerated row, in row order
+		// finds the next byte on which the start state does not die; only set if there are few such bytes
+		std::optional<DFAAccelerator> m_StartSkip;
 
 		// static variables
 		constexpr static state_t DEAD_STATE = 0;
+		// the number of inputs a batch simulation advances in lockstep
+		constexpr static size_t BATCH_LANES = 8;
+		// by default, a parallel simulation gives every thread at least this many characters
+		constexpr static size_t PARALLEL_MIN_CHUNK = 1 << 18;
+		// the characters before a chunk that are used to narrow down the state the chunk starts in
+		constexpr static size_t PARALLEL_LOOKBACK = 64;
+		// a chunk is run from at most this many candidate start states
+		constexpr static size_t PARALLEL_MAX_CANDIDATES = 4;
 
 		// private methods
-		FSMResult _simulate_whole_string(const InputT&) const;
-		FSMResult _simulate_longest_prefix(const InputT&) const;
-		FSMResult _simulate_longest_substring(const InputT&) const;
+		void _compile();
+
+		/**
+		* The states used while simulating depend on the execution mode:
+		* EM_CHECKED uses plain state ids and steps through the transition function.
+		* EM_PREMULTIPLIED uses renumbered, premultiplied state ids and steps through the class table.
+		*/
+		template <FSM_EXEC_MODE ExecMode>
+		state_t _start_state() const {
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				return m_StartState;
+			else
+				return FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+		};
+
+		/**
+		* Call `func.template operator()<EntryT>()` with the type the class table entries are stored in.
+		* The width is looked up once per call, so the loops inside read the table at its own width without further branching.
+		*/
+		template <typename FuncT>
+		decltype(auto) _with_entry_type(FuncT&& func) const {
+			switch (m_ClassTable.entrySize()) {
+			case sizeof(std::uint8_t):
+				return func.template operator()<std::uint8_t>();
+			case sizeof(std::uint16_t):
+				return func.template operator()<std::uint16_t>();
+			default:
+				return func.template operator()<state_t>();
+			}
+		};
+
+		// `EntryT` is the entry type of the class table; EM_CHECKED ignores it
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		state_t _next_state(state_t state, unsigned char c) const {
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				return static_cast<const EntryT*>(m_ClassTable.data())[state + m_ByteClasses[c]];
+			else
+				return c < this->m_TransitionFunc.m_InputMax ? (state_t)this->m_TransitionFunc(state, c) : DEAD_STATE;
+		};
+
+		template <FSM_EXEC_MODE ExecMode>
+		bool _is_final(state_t state) const {
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				return state >= m_FinalStart;
+			else
+				return this->getFinalStates().contains(state);
+		};
+
+		// accelerated states exist only in the premultiplied form
+		bool _is_accelerated(state_t state) const {
+			return state - m_AccelStart < m_AccelEnd - m_AccelStart;
+		};
+
+		const DFAAccelerator& _accelerator(state_t state) const {
+			return m_Accelerators[(state - m_AccelStart) / m_ClassTable.inputCount()];
+		};
+
+		// the row of the state, which is a dense index in [0, number of states)
+		template <FSM_EXEC_MODE ExecMode>
+		size_t _state_index(state_t state) const {
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				return state / m_ClassTable.inputCount();
+			else
+				return state;
+		};
+
+		// the id of the state as given by the transition function
+		template <FSM_EXEC_MODE ExecMode>
+		state_t _state_id(state_t state) const {
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				return m_StateIds[_state_index<ExecMode>(state)];
+			else
+				return state;
+		};
+
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		state_t _run(state_t, std::string_view) const;
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		FSMResult _simulate_whole_string(std::string_view) const;
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		FSMResult _simulate_longest_prefix(std::string_view) const;
+		/**
+		* The state of a longest-substring search, which _scan_longest_substring() advances one piece of input at a time:
+		* the live attempts, the generation in which each state was last claimed and the best match so far, its offsets counting from the first byte scanned.
+		* Searches that scan many times, such as findAll(), create it once and restart() it for every scan;
+		* DFAStreamMatcher keeps one across the chunks it is fed.
+		*/
+		struct SubstringScan {
+			constexpr static size_t NO_MATCH = (size_t)-1;
+
+			struct Attempt {
+				state_t state;
+				size_t start;
+			};
+
+			std::vector<Attempt> currAttempts, nextAttempts;
+			std::vector<size_t> claimed;
+			size_t generation = 0;
 
-		bool _check_accepted_longest_prefix(const std::vector<state_t>&, size_t&) const;
-		bool _check_accepted_substring(const InputT&, std::vector<state_t>&, size_t, size_t&) const;
+			size_t matchStart = NO_MATCH, matchEnd = 0;
+			state_t matchState = DEAD_STATE;
+
+			explicit SubstringScan(size_t stateCount) : claimed(stateCount, 0) {};
+
+			// forget the attempts and the match; a new generation makes the old claims stale, so they need no clearing
+			void restart() {
+				currAttempts.clear();
+				generation++;
+				matchStart = NO_MATCH;
+				matchEnd = 0;
+				matchState = DEAD_STATE;
+			};
+		};
+		SubstringScan _substring_scan() const { return SubstringScan{ m_ClassTable.stateCount() }; };
+
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		bool _scan_longest_substring(std::string_view, SubstringScan&, size_t from, size_t startLimit, size_t offset) const;
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		FSMResult _simulate_longest_substring(std::string_view, SubstringScan&, size_t = 0, size_t = (size_t)-1) const;
+		template <FSM_EXEC_MODE ExecMode, typename EntryT>
+		FSMResult _simulate(std::string_view, FSM_MODE) const;
+		template <typename EntryT, typename StringT>
+		void _simulate_batch(std::span<const StringT>, FSM_MODE, std::span<FSMResult>) const;
+		template <typename EntryT>
+		FSMResult _simulate_parallel(std::string_view, size_t, size_t) const;
+		template <typename EntryT>
+		std::vector<FSMResult> _find_all(std::string_view) const;
+		template <typename EntryT>
+		std::vector<FSMResult> _find_all_parallel(std::string_view, size_t, size_t) const;
+
+		// used by DFASerializer::load(), which fills in the compiled form from the file
+		struct Precompiled {};
+		DeterFiniteAutomatan(Precompiled, const state_set_t& fStates, const TransFuncT& tranFn, flag_t flags) :
+			FiniteStateMachine<TransFuncT, InputT> {fStates, tranFn, FSM_TYPE::MT_DFA, flags}
+		{};
 		
 	public:
-		DeterFiniteAutomatan() = default;
+		DeterFiniteAutomatan() { _compile(); };
 		DeterFiniteAutomatan(const state_set_t& fStates, const TransFuncT& tranFn, flag_t flags = FSM_FLAG::FF_FLAG_MAX) :
 			FiniteStateMachine<TransFuncT, InputT> {fStates, tranFn, FSM_TYPE::MT_DFA, flags}
-		{};
+		{
+			_compile();
+		};
+
+		FSMResult simulate(std::string_view, FSM_MODE, FSM_EXEC_MODE = FSM_EXEC_MODE::EM_PREMULTIPLIED) const;
+		FSMResult simulate(std::span<const std::byte> input, FSM_MODE mode, FSM_EXEC_MODE execMode = FSM_EXEC_MODE::EM_PREMULTIPLIED) const {
+			return this->simulate(toStringView(input), mode, execMode);
+		};
+		// simulate a batch of inputs, given as views or as InputT strings, into `results`
+		void simulate(std::span<const std::string_view> inputs, FSM_MODE mode, std::span<FSMResult> results) const {
+			this->_with_entry_type([&]<typename EntryT>() { this->_simulate_batch<EntryT>(inputs, mode, results); });
+		};
+		void simulate(std::span<const InputT> inputs, FSM_MODE mode, std::span<FSMResult> results) const requires (!std::is_same_v<InputT, std::string_view>) {
+			this->_with_entry_type([&]<typename EntryT>() { this->_simulate_batch<EntryT>(inputs, mode, results); });
+		};
+		FSMResult simulateParallel(std::string_view input, size_t threadCount = 0, size_t minChunk = PARALLEL_MIN_CHUNK) const {
+			return this->_with_entry_type([&]<typename EntryT>() { return this->_simulate_parallel<EntryT>(input, threadCount, minChunk); });
+		};
+		std::vector<FSMResult> findAll(std::string_view input) const {
+			return this->_with_entry_type([&]<typename EntryT>() { return this->_find_all<EntryT>(input); });
+		};
+		std::vector<FSMResult> findAllParallel(std::string_view input, size_t threadCount = 0, size_t minChunk = PARALLEL_MIN_CHUNK) const {
+			return this->_with_entry_type([&]<typename EntryT>() { return this->_find_all_parallel<EntryT>(input, threadCount, minChunk); });
+		};
+		// the number of chunks simulateParallel() and findAllParallel() split an input of `inputSize` characters into; 1 or less means it is not split
+		static size_t parallelChunkCount(size_t inputSize, size_t threadCount = 0, size_t minChunk = PARALLEL_MIN_CHUNK) {
+			if (threadCount == 0)
+				threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+			return std::min(threadCount, inputSize / std::max<size_t>(minChunk, 1));
+		};
+		std::vector<FSMResult> findAll(std::span<const std::byte> input) const { return this->findAll(toStringView(input)); };
 
-		FSMResult simulate(const InputT&, FSM_MODE) const;
+		using FiniteStateMachine<TransFuncT, InputT>::getFinalStates;
+		using FiniteStateMachine<TransFuncT, InputT>::getFlags;
+		const TransFuncT& getTransitionFunction() const { return this->m_TransitionFunc; };
+		size_t getClassCount() const { return m_ClassTable.inputCount(); };
+		const ByteClassMap& getByteClasses() const { return m_ByteClasses; };
 		
 	};
 
@@ -40,192 +268,757 @@ namespace m0st4fa {
 	
 
 	// IMPLEMENTATIONS
+	/**
+	* @brief Compute the byte classes of the transition function and build the class-compressed table used by simulate().
+	*/
 	template<typename TransFuncT, typename InputT>
-	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_whole_string(const InputT& input) const
+	void DeterFiniteAutomatan<TransFuncT, InputT>::_compile()
 	{
-		state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		state_t currState = startState;
+		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+		const size_t stateMax = this->m_TransitionFunc.m_StateMax;
+		const size_t inputMax = std::min<size_t>(this->m_TransitionFunc.m_InputMax, BYTE_COUNT);
+
+		// bytes outside of the table go to the dead state from every state
+		auto target = [this, inputMax](state_t state, size_t b) -> state_t {
+			return b < inputMax ? (state_t)this->m_TransitionFunc(state, b) : DEAD_STATE;
+		};
+
+		/**
+		* Start with all the bytes in a single class and let every state refine the partition.
+		* Two bytes stay in the same class only if they had the same class and the state moves to the same state on both of them.
+		*/
+		std::array<size_t, BYTE_COUNT> classOf{};
+		size_t classCount = 1;
+
+		for (state_t state = 0; state < stateMax; state++) {
+			std::map<std::pair<size_t, state_t>, size_t> refined;
+
+			for (size_t b = 0; b < BYTE_COUNT; b++) {
+				auto it = refined.try_emplace({ classOf[b], target(state, b) }, refined.size()).first;
+				classOf[b] = it->second;
+			}
+
+			classCount = refined.size();
+		}
+
+		// pick a representative byte for each class
+		std::vector<size_t> representative(classCount);
+		for (size_t b = BYTE_COUNT; b-- > 0; ) {
+			m_ByteClasses[b] = (byte_class_t)classOf[b];
+			representative[classOf[b]] = b;
+		}
+
+		// keep at least the dead and the start rows so that an empty machine rejects everything
+		const size_t stateCount = std::max<size_t>(stateMax, startState + 1);
 
+		/**
+		* Build an accelerator from the bytes for which `isExit` holds, if there are few enough of them.
+		* The high bytes may be exits as a whole on top of at most ACCEL_BYTE_MAX low exit bytes.
+		*/
+		auto makeAccelerator = [](auto isExit) -> std::optional<DFAAccelerator> {
+			DFAAccelerator accel;
+			size_t lowCount = 0, highCount = 0;
+
+			for (size_t b = 0; b < BYTE_COUNT; b++)
+				if (isExit(b))
+					(b < 0x80 ? lowCount : highCount)++;
+
+			if (lowCount + highCount <= DFAAccelerator::ACCEL_BYTE_MAX)
+				accel.exitsOnHighBytes = false;
+			else if (highCount == BYTE_COUNT - 0x80 && lowCount <= DFAAccelerator::ACCEL_BYTE_MAX)
+				accel.exitsOnHighBytes = true;
+			else
+				return std::nullopt;
+
+			for (size_t b = 0; b < BYTE_COUNT; b++)
+				if (isExit(b) && (b < 0x80 || -not accel.exitsOnHighBytes))
+					accel.exitBytes[accel.exitCount++] = (unsigned char)b;
+
+			for (size_t i = accel.exitCount; i < DFAAccelerator::ACCEL_BYTE_MAX; i++)
+				accel.exitBytes[i] = accel.exitBytes[0];
+
+			return accel;
+		};
+
+		// a state is accelerated when it leaves itself on few bytes
+		std::vector<std::optional<DFAAccelerator>> accelOf(stateCount);
+		for (state_t state = 1; state < stateCount; state++)
+			accelOf[state] = makeAccelerator([&](size_t b) { return target(state, b) != state; });
+
+		m_StartSkip = makeAccelerator([&](size_t b) { return target(startState, b) != DEAD_STATE; });
+
+		/**
+		* Renumber the states so that acceptance and acceleration are comparisons:
+		* the dead state keeps row 0, then come the non-final states, the accelerated non-final states,
+		* the accelerated final states and the final states.
+		*/
+		const state_set_t& finalStates = this->getFinalStates();
+		auto storage = std::make_shared<CompiledStorage>();
+		std::vector<state_t>& stateIds = storage->stateIds;
+		std::vector<state_t> rowOf(stateCount);
+		stateIds.assign(1, DEAD_STATE);
+
+		for (size_t group = 0; group < 4; group++) {
+			const bool final = group >= 2, accelerated = group == 1 || group == 2;
+			const state_t groupStart = (state_t)(stateIds.size() * classCount);
+
+			if (group == 1)
+				m_AccelStart = groupStart;
+			if (group == 2)
+				m_FinalStart = groupStart;
+			if (group == 3)
+				m_AccelEnd = groupStart;
+
+			for (state_t state = 1; state < stateCount; state++)
+				if (finalStates.contains(state) == final && accelOf[state].has_value() == accelerated) {
+					rowOf[state] = (state_t)stateIds.size();
+					stateIds.push_back(state);
+
+					if (accelerated)
+						storage->accelerators.push_back(*accelOf[state]);
+				}
+		}
+
+		m_StartState = rowOf[startState] * (state_t)classCount;
+
+		// build the compressed rows, as narrow as the largest premultiplied state allows
+		auto build = [&]<typename EntryT>() {
+			FSMDynamicTable<EntryT>& classTable = storage->classTable.template emplace<FSMDynamicTable<EntryT>>(stateCount, classCount, (EntryT)DEAD_STATE);
+
+			for (state_t state = 0; state < stateMax; state++)
+				for (size_t cls = 0; cls < classCount; cls++) {
+					state_t next = target(state, representative[cls]);
+
+					// validate the table once, so that the premultiplied form can step through it without bounds checks
+					if (next >= stateCount) {
+						LoggerInfo loggerInfo = {
+							  .level = LOG_LEVEL::LL_ERROR,
+							  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+						};
+						const std::string message = "DeterFiniteAutomatan: the transition function moves to state " + std::to_string(next) + " which has no row in the table.";
+						this->m_Logger.log(loggerInfo, message);
+						throw std::invalid_argument(message);
+					}
+
+					classTable(rowOf[state], cls) = (EntryT)(rowOf[next] * classCount);
+				}
+
+			m_ClassTable = FSMPackedTableView{ classTable };
+		};
+
+		const size_t maxEntry = (stateCount - 1) * classCount;
+		if (maxEntry <= UINT8_MAX)
+			build.template operator()<std::uint8_t>();
+		else if (maxEntry <= UINT16_MAX)
+			build.template operator()<std::uint16_t>();
+		else
+			build.template operator()<state_t>();
+		m_StateIds = stateIds;
+		m_Accelerators = storage->accelerators;
+		m_Storage = std::move(storage);
+	}
+
+	/**
+	* @brief Return the state reached from `currState` after consuming the whole input, or the dead state if the path dies.
+	*/
+	template<typename TransFuncT, typename InputT>
+	template<FSM_EXEC_MODE ExecMode, typename EntryT>
+	state_t DeterFiniteAutomatan<TransFuncT, InputT>::_run(state_t currState, std::string_view input) const
+	{
 		/**
 		 * Follow a path through the machine using the characters of the string.
 		 * Break if you hit a dead state since it is dead.
+		 * An accelerated state stays where it is until one of its exit bytes, so jump straight to that byte.
 		*/
-		for (auto c : input) {
-			currState = this->m_TransitionFunc(currState, c);
+		for (size_t charIndex = 0; charIndex < input.size(); ) {
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				if (this->_is_accelerated(currState)) {
+					charIndex = this->_accelerator(currState).skip(input.data(), charIndex, input.size());
+
+					if (charIndex == input.size())
+						break;
+				}
+
+			currState = this->_next_state<ExecMode, EntryT>(currState, input[charIndex++]);
 
 			if (currState == DEAD_STATE)
 				break;
 		}
 
-		bool accepted = this->getFinalStates().contains(currState);
+		return currState;
+	}
 
-		return FSMResult(accepted, accepted ? state_set_t{currState} : state_set_t{startState}, { 0, accepted ? input.size() : 0 }, input);
+	template<typename TransFuncT, typename InputT>
+	template<FSM_EXEC_MODE ExecMode, typename EntryT>
+	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_whole_string(std::string_view input) const
+	{
+		state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+		state_t currState = this->_run<ExecMode, EntryT>(this->_start_state<ExecMode>(), input);
+
+		bool accepted = this->_is_final<ExecMode>(currState);
+		currState = this->_state_id<ExecMode>(currState);
+
+		return FSMResult(accepted, accepted ? currState : startState, { 0, accepted ? input.size() : 0 }, input);
 	}
 
 	template<typename TransFuncT, typename InputT>
-	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_prefix(const InputT& input) const
+	template<FSM_EXEC_MODE ExecMode, typename EntryT>
+	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_prefix(std::string_view input) const
 	{
 		state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		state_t currState = startState;
+		state_t currState = this->_start_state<ExecMode>();
+
 		/**
-		* keeps track of the path taken through the machine.
-		* Will be used to figure out the longest matched prefix, if any.
-		*/ 
-		std::vector matchedStates = { currState };
+		* Only the last final state reached and the number of characters consumed to reach it are remembered.
+		* They describe the longest accepted prefix so far, so no path through the machine needs to be kept.
+		*/
+		state_t lastFinalState = startState;
+		size_t lastFinalIndex = 0;
 
 		/**
 		 * Follow a path through the machine using the characters of the string.
-		 * Keep track of that path in order to be able to find the longest prefix if the whole string is not accepted.
 		 * Break if you hit a dead state since it is dead.
 		*/
-		for (auto c : input) {
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+			// skip the bytes on which an accelerated state stays where it is; each of them extends the prefix if the state is final
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED)
+				if (this->_is_accelerated(currState)) {
+					size_t exitIndex = this->_accelerator(currState).skip(input.data(), charIndex, input.size());
+
+					if (exitIndex > charIndex && this->_is_final<ExecMode>(currState)) {
+						lastFinalState = currState;
+						lastFinalIndex = exitIndex;
+					}
+
+					charIndex = exitIndex;
+					if (charIndex == input.size())
+						break;
+				}
+
 			// get next state
-			currState = this->m_TransitionFunc(currState, c);
+			currState = this->_next_state<ExecMode, EntryT>(currState, input[charIndex]);
 
 			// break out if it is dead
 			if (currState == DEAD_STATE)
 				break;
 
-			// update our path through the machine
-			matchedStates.push_back(currState);
+			// remember the longest accepted prefix
+			if (this->_is_final<ExecMode>(currState)) {
+				lastFinalState = currState;
+				lastFinalIndex = charIndex + 1;
+			}
 		}
 
-		size_t index = matchedStates.size();
-	 	this->m_Logger.logDebug(std::format("[DFA] index of the last checked character: {}\n[DFA] size of matchedStates: {}\n", index, matchedStates.size()));
-		//assert(index == matchedStates.size());
-		// figure out whether there is an accepted longest prefix
-		bool accepted = _check_accepted_longest_prefix(matchedStates, index);
+		bool accepted = lastFinalIndex > 0;
 
 #if defined(_DEBUG)
-		std::cout << "[DFA] matched set of states (path through the FSM): " << matchedStates;
+		this->m_Logger.logDebug(std::format("[DFA] length of the longest accepted prefix: {}\n", lastFinalIndex));
 #endif
 
-		return FSMResult(accepted, accepted ? state_set_t{ matchedStates.at(index) } : state_set_t{startState}, {0, index}, input);
+		return FSMResult(accepted, accepted ? this->_state_id<ExecMode>(lastFinalState) : startState, { 0, lastFinalIndex }, input);
 	}
 
+	/**
+	* Advance `scan` over `input[from, input.size())`, whose byte `charIndex` is at offset `offset + charIndex` of the whole input.
+	* New attempts start only before `startLimit`, and the scan stops early once no attempt is live and none may start.
+	* Returns whether the match is settled, that is no attempt can extend or replace it, so that the rest of the input need not be scanned.
+	*/
 	template<typename TransFuncT, typename InputT>
-	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_substring(const InputT& input) const
+	template<FSM_EXEC_MODE ExecMode, typename EntryT>
+	bool DeterFiniteAutomatan<TransFuncT, InputT>::_scan_longest_substring(std::string_view input, SubstringScan& scan, size_t from, size_t startLimit, size_t offset) const
 	{
-		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		/**
-		* keeps track of the path taken through the machine.
-		* Will be used to figure out the longest matched prefix, if any.
-		*/
-		std::vector matchedStates = { startState };
-		size_t startIndex = 0, charIndex = 0;
+		const state_t execStartState = this->_start_state<ExecMode>();
+		const size_t execStartIndex = this->_state_index<ExecMode>(execStartState);
+		constexpr size_t NO_MATCH = SubstringScan::NO_MATCH;
 
 		/**
-		 * Follow a path through the machine using the characters of the string until you check all the characters.
-		 * Keep track of that path in order to be able to find the longest prefix if the whole string is not accepted.
-		 * Break if you hit a dead state since it is dead.
-		 * If a substring was not accepted, start matching the next substring if any
+		* All the match attempts are run together in a single forward pass, as if the machine had an implicit `.*?` loop before its start state.
+		* An attempt is a state paired with the offset at which the attempt started; the list is kept ordered by start offset.
+		* Attempts that reach the same state share the same future, so only the one that started first (the leftmost) is kept.
+		* This bounds the number of live attempts by the number of states and makes the scan linear in the length of the input.
 		*/
-		for (; startIndex < input.size(); charIndex = ++startIndex) {
-			
-			bool accepted = _check_accepted_substring(input, matchedStates, startIndex, charIndex);
+		using Attempt = typename SubstringScan::Attempt;
+
+		std::vector<Attempt>& currAttempts = scan.currAttempts;
+		std::vector<Attempt>& nextAttempts = scan.nextAttempts;
+		// the generation in which each state was last claimed by an attempt
+		std::vector<size_t>& claimed = scan.claimed;
+		size_t& generation = scan.generation;
+
+		// the match is kept in locals during the scan, where the stores into `claimed` cannot alias it
+		size_t matchStart = scan.matchStart, matchEnd = scan.matchEnd;
+		state_t matchState = scan.matchState;
+		bool settled = false;
 
-			// if this substring was not accepted
-			if (-not accepted)
-				continue;
+		for (size_t charIndex = from; charIndex < input.size(); charIndex++) {
 
-			// if it was accepted:
-			typedef unsigned long ull;
-			return FSMResult{ true, state_set_t { matchedStates.at(charIndex - startIndex) }, {(ull)startIndex, (ull)charIndex}, input };
+			// no attempt is live and no new attempt may start
+			if (currAttempts.empty() && charIndex >= startLimit)
+				break;
+
+			if constexpr (ExecMode == FSM_EXEC_MODE::EM_PREMULTIPLIED) {
+				// with no live attempt, an attempt can only survive from a byte on which the start state does not die
+				if (currAttempts.empty() && matchStart == NO_MATCH && m_StartSkip) {
+					charIndex = m_StartSkip->skip(input.data(), charIndex, startLimit);
+
+					if (charIndex == startLimit)
+						break;
+				}
+
+				// a lone attempt that cannot be replaced behaves like a longest-prefix search
+				if (currAttempts.size() == 1 && matchStart != NO_MATCH && this->_is_accelerated(currAttempts[0].state)) {
+					const state_t state = currAttempts[0].state;
+					size_t exitIndex = this->_accelerator(state).skip(input.data(), charIndex, input.size());
+
+					if (exitIndex > charIndex && this->_is_final<ExecMode>(state)) {
+						matchStart = currAttempts[0].start;
+						matchEnd = offset + exitIndex;
+						matchState = state;
+					}
+
+					charIndex = exitIndex;
+					if (charIndex == input.size())
+						break;
+				}
+			}
+
+			// start a new attempt at this index, unless a match is already found (a later attempt cannot be leftmost)
+			if (matchStart == NO_MATCH && charIndex < startLimit && claimed[execStartIndex] != generation) {
+				claimed[execStartIndex] = generation;
+				currAttempts.push_back({ execStartState, offset + charIndex });
+			}
+
+			generation++;
+			nextAttempts.clear();
+			const auto c = input[charIndex];
+
+			for (const Attempt& attempt : currAttempts) {
+				// attempts that started after the current match cannot replace it
+				if (attempt.start > matchStart && matchStart != NO_MATCH)
+					break;
+
+				state_t nextState = this->_next_state<ExecMode, EntryT>(attempt.state, c);
+				size_t nextStateIndex = this->_state_index<ExecMode>(nextState);
+
+				// the attempt dies or is merged into an attempt that started earlier
+				if (nextState == DEAD_STATE || claimed[nextStateIndex] == generation)
+					continue;
+
+				claimed[nextStateIndex] = generation;
+				nextAttempts.push_back({ nextState, attempt.start });
+
+				// prefer the leftmost start, then the longest end
+				if (this->_is_final<ExecMode>(nextState) && (matchStart == NO_MATCH || attempt.start <= matchStart)) {
+					matchStart = attempt.start;
+					matchEnd = offset + charIndex + 1;
+					matchState = nextState;
+				}
+
+			}
+
+			std::swap(currAttempts, nextAttempts);
+
+			// no attempt can extend or replace the match
+			if (currAttempts.empty() && matchStart != NO_MATCH) {
+				settled = true;
+				break;
+			}
 		}
 
-		return FSMResult(false, state_set_t {startState}, {0, 0}, input);
+		scan.matchStart = matchStart;
+		scan.matchEnd = matchEnd;
+		scan.matchState = matchState;
+
+		return settled;
+	}
+
+	/**
+	* @brief Find the leftmost-longest match that starts in [from, until); the match itself may end past `until`.
+	*/
+	template<typename TransFuncT, typename InputT>
+	template<FSM_EXEC_MODE ExecMode, typename EntryT>
+	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_substring(std::string_view input, SubstringScan& scan, size_t from, size_t until) const
+	{
+		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+
+		scan.restart();
+		this->_scan_longest_substring<ExecMode, EntryT>(input, scan, from, std::min(input.size(), until), 0);
+
+		if (scan.matchStart == SubstringScan::NO_MATCH)
+			return FSMResult(false, startState, {0, 0}, input);
+
+		return FSMResult{ true, this->_state_id<ExecMode>(scan.matchState), { scan.matchStart, scan.matchEnd }, input };
 	}
 	
 	template<typename TransFuncT, typename InputT>
-	inline bool DeterFiniteAutomatan<TransFuncT, InputT>::_check_accepted_longest_prefix(const std::vector<state_t>& matchedStates, size_t& index) const
+	template<FSM_EXEC_MODE ExecMode, typename EntryT>
+	inline FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate(std::string_view input, FSM_MODE mode) const
+	{
+		switch (mode) {
+		case FSM_MODE::MM_WHOLE_STRING:
+			return this->_simulate_whole_string<ExecMode, EntryT>(input);
+		case FSM_MODE::MM_LONGEST_PREFIX:
+			return this->_simulate_longest_prefix<ExecMode, EntryT>(input);
+		case FSM_MODE::MM_LONGEST_SUBSTRING: {
+			SubstringScan scan = this->_substring_scan();
+			return this->_simulate_longest_substring<ExecMode, EntryT>(input, scan);
+		}
+		default:
+			std::cerr << "Unreachable: simulate() cannot reach this point." << std::endl;
+			// TODO: throw a better exception
+			throw std::runtime_error("The provided mode is erroneous in function DFA::simulate().");
+		}
+
+	}
+
+	/**
+	* @brief Simulate the given input string using the given simulation method.
+	* The input is only viewed, never copied; the result views the same memory and reports the match as offsets into it.
+	* EM_PREMULTIPLIED steps through the validated class table without bounds checks.
+	* EM_CHECKED steps through the transition function with bounds checks; use it for debugging.
+	*/
+	template<typename TransFuncT, typename InputT>
+	inline FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::simulate(std::string_view input, FSM_MODE mode, FSM_EXEC_MODE execMode) const
 	{
-		bool accepted = false;
+		switch (execMode) {
+		case FSM_EXEC_MODE::EM_PREMULTIPLIED:
+			return this->_with_entry_type([&]<typename EntryT>() { return this->_simulate<FSM_EXEC_MODE::EM_PREMULTIPLIED, EntryT>(input, mode); });
+		case FSM_EXEC_MODE::EM_CHECKED:
+			return this->_simulate<FSM_EXEC_MODE::EM_CHECKED, state_t>(input, mode);
+		default:
+			std::cerr << "Unreachable: simulate() cannot reach this point." << std::endl;
+			throw std::runtime_error("The provided execution mode is erroneous in function DFA::simulate().");
+		}
+
+	}
+
+	/**
+	* @brief Simulate the input in whole-string mode, splitting it across `threadCount` threads (all the hardware threads if 0).
+	* Every thread runs a chunk of the input into a mapping from the states the chunk may start in to the states it ends in,
+	* and the mappings are composed in order at the end. The result is the same as simulate() in whole-string mode.
+	* Inputs too short to give every thread `minChunk` characters use fewer threads, down to a plain simulate().
+	*/
+	template<typename TransFuncT, typename InputT>
+	template<typename EntryT>
+	FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_parallel(std::string_view input, size_t threadCount, size_t minChunk) const
+	{
+		constexpr FSM_EXEC_MODE ExecMode = FSM_EXEC_MODE::EM_PREMULTIPLIED;
 		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
 
+		threadCount = parallelChunkCount(input.size(), threadCount, minChunk);
+
+		if (threadCount <= 1)
+			return this->_simulate_whole_string<ExecMode, EntryT>(input);
+
+		struct Chunk {
+			size_t begin = 0;
+			std::string_view text;
+			std::vector<state_t> candidates; // the states the chunk is run from
+			std::vector<state_t> ends; // `ends[i]` is the state reached from `candidates[i]`
+		};
+
+		const size_t chunkSize = input.size() / threadCount;
+		std::vector<Chunk> chunks(threadCount);
+
+		for (size_t i = 0; i < threadCount; i++) {
+			chunks[i].begin = i * chunkSize;
+			chunks[i].text = input.substr(chunks[i].begin, i + 1 == threadCount ? std::string_view::npos : chunkSize);
+		}
+
 		/**
-		* Loop through the path from the end seeking the closes final state.
-		* Update the end index as you do so.
-		* The number of states in the set is: (the number of characters in the longest prefix + 1, the start state).
-		* The last state in the matchedSet is almost guaranteed failed state.
+		* Whatever state the machine is in before the lookback window, it is in one of the states the window leads to at the start of the chunk.
+		* A DFA tends to forget where it came from within a few characters, so these states are usually few:
+		* if there are at most PARALLEL_MAX_CANDIDATES of them the chunk is run from each and the mapping is exact,
+		* otherwise it is run from the one most states lead to, and a wrong guess is re-run once the true start state is known.
 		*/
-		auto it = matchedStates.rbegin();
-		while (it != matchedStates.rend())
-		{
-			state_t currState = *it;
-			
-			// if the currunt state is the start state
-			if (currState == startState) {
-				break;
-			}
+		auto speculate = [this, input](Chunk& chunk) {
+			const size_t classCount = m_ClassTable.inputCount();
+			const size_t lookbackSize = std::min(PARALLEL_LOOKBACK, chunk.begin);
+			const std::string_view lookback = input.substr(chunk.begin - lookbackSize, lookbackSize);
 
-			// set up the iterator and the index for the next iteration
-			index--;
-			it++;
+			std::vector<size_t> hits(m_ClassTable.stateCount(), 0);
+			state_t guess = DEAD_STATE;
 
-			// if the current state is a final state
-			if (this->getFinalStates().contains(currState)) {
-				accepted = true;
-				break;
+			for (size_t row = 1; row < m_ClassTable.stateCount(); row++) {
+				state_t state = this->_run<ExecMode, EntryT>((state_t)(row * classCount), lookback);
+
+				// a path that dies rejects the input whatever follows, so the chunk need not be run from the dead state
+				if (state == DEAD_STATE)
+					continue;
+
+				size_t index = this->_state_index<ExecMode>(state);
+				if (hits[index]++ == 0)
+					chunk.candidates.push_back(state);
+				if (guess == DEAD_STATE || hits[index] > hits[this->_state_index<ExecMode>(guess)])
+					guess = state;
 			}
 
+			if (chunk.candidates.size() > PARALLEL_MAX_CANDIDATES)
+				chunk.candidates = { guess };
+		};
+
+		auto work = [this, &speculate](Chunk& chunk) {
+			if (chunk.candidates.empty())
+				speculate(chunk);
+
+			for (state_t state : chunk.candidates)
+				chunk.ends.push_back(this->_run<ExecMode, EntryT>(state, chunk.text));
+		};
+
+		chunks[0].candidates = { this->_start_state<ExecMode>() };
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (size_t i = 1; i < threadCount; i++)
+			threads.emplace_back(work, std::ref(chunks[i]));
+
+		work(chunks[0]);
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		// compose the mappings, re-running the chunks whose start state was not speculated
+		state_t currState = chunks[0].ends[0];
+
+		for (size_t i = 1; i < threadCount && currState != DEAD_STATE; i++) {
+			const Chunk& chunk = chunks[i];
+			auto it = std::find(chunk.candidates.begin(), chunk.candidates.end(), currState);
+
+			currState = it != chunk.candidates.end() ? chunk.ends[it - chunk.candidates.begin()] : this->_run<ExecMode, EntryT>(currState, chunk.text);
 		}
-		
-		return accepted;
+
+		bool accepted = this->_is_final<ExecMode>(currState);
+
+		return FSMResult(accepted, accepted ? this->_state_id<ExecMode>(currState) : startState, { 0, accepted ? input.size() : 0 }, input);
 	}
 
+	/**
+	* @brief Return the non-overlapping leftmost-longest matches of the input, in order.
+	* Every search resumes at the end of the previous match; matches are never empty, so the scan always moves forward.
+	*/
 	template<typename TransFuncT, typename InputT>
-	bool DeterFiniteAutomatan<TransFuncT, InputT>::_check_accepted_substring(const InputT& input, std::vector<state_t>& matchedStates, size_t startIndex, size_t& charIndex) const
+	template<typename EntryT>
+	std::vector<FSMResult> DeterFiniteAutomatan<TransFuncT, InputT>::_find_all(std::string_view input) const
 	{
-		state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		state_t currState = startState;
-		// start from startIndex until the end of the string or until you reach a dead state
-			/**
-			* The value of charIndex will be correct because the last time we increment it, the condition is guaranteed to fail.
-			* This guarantees that charIndex will always equal: the number of matched characters + startIndex.
-			*/
-
-		for (; charIndex < input.size(); charIndex++) {
-			// get next state
-			auto c = input[charIndex];
-			currState = this->m_TransitionFunc(currState, c);
+		std::vector<FSMResult> matches;
+		SubstringScan scan = this->_substring_scan();
 
-			// break out if it is dead
-			if (currState == DEAD_STATE)
+		for (size_t from = 0; from < input.size(); ) {
+			FSMResult match = this->_simulate_longest_substring<FSM_EXEC_MODE::EM_PREMULTIPLIED, EntryT>(input, scan, from);
+
+			if (-not match.accepted)
 				break;
 
-			// update the path through the machine
-			matchedStates.push_back((state_t)currState);
+			from = match.indecies.end;
+			matches.push_back(match);
+		}
+
+		return matches;
+	}
+
+	/**
+	* @brief Return the same matches as findAll(), splitting the input across `threadCount` threads (all the hardware threads if 0).
+	* Every thread collects the matches that start in its chunk, scanning as if no match of the previous chunk ran into it.
+	* The chunks are then stitched in order: when the last match so far ends inside a chunk, the chunk is re-scanned from that end
+	* until the re-scan reaches a point the thread's own scan also passed through; from there on both scans find the same matches.
+	* Since the re-scan stops as soon as the scans agree, this needs no bound on the length of a match.
+	* As with simulateParallel(), inputs too short to give every thread `minChunk` characters use fewer threads.
+	*/
+	template<typename TransFuncT, typename InputT>
+	template<typename EntryT>
+	std::vector<FSMResult> DeterFiniteAutomatan<TransFuncT, InputT>::_find_all_parallel(std::string_view input, size_t threadCount, size_t minChunk) const
+	{
+		constexpr FSM_EXEC_MODE ExecMode = FSM_EXEC_MODE::EM_PREMULTIPLIED;
+
+		threadCount = parallelChunkCount(input.size(), threadCount, minChunk);
+
+		if (threadCount <= 1)
+			return this->_find_all<EntryT>(input);
+
+		const size_t chunkSize = input.size() / threadCount;
+		auto chunkBegin = [&](size_t i) { return i * chunkSize; };
+		auto chunkEnd = [&](size_t i) { return i + 1 == threadCount ? input.size() : (i + 1) * chunkSize; };
+
+		std::vector<std::vector<FSMResult>> found(threadCount);
+
+		// every thread scans with its own search state
+		auto work = [&](size_t i) {
+			SubstringScan scan = this->_substring_scan();
+
+			for (size_t from = chunkBegin(i); from < chunkEnd(i); ) {
+				FSMResult match = this->_simulate_longest_substring<ExecMode, EntryT>(input, scan, from, chunkEnd(i));
+
+				if (-not match.accepted)
+					break;
+
+				from = match.indecies.end;
+				found[i].push_back(match);
+			}
 		};
 
-		// endIndex = number of characters checked + the offset of the substring into the input string
-		size_t endIndex = matchedStates.size() + startIndex;
-		//this->m_Logger.logDebug(std::format("at _check_accepted_substring: charIndex: {}, endIndex: {}\n", charIndex, endIndex));
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (size_t i = 1; i < threadCount; i++)
+			threads.emplace_back(work, i);
 
-		// figure out whether there is an accepted longest prefix
-		bool accepted = _check_accepted_longest_prefix(matchedStates, endIndex);
-		
-		return accepted;
-	};
+		work(0);
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		// stitch the chunks
+		std::vector<FSMResult> matches = std::move(found[0]);
+		SubstringScan scan = this->_substring_scan();
+
+		for (size_t i = 1; i < threadCount; i++) {
+			const std::vector<FSMResult>& chunkMatches = found[i];
+			size_t from = matches.empty() ? 0 : (size_t)matches.back().indecies.end;
+			size_t next = 0; // the first match of the chunk that starts at or after `from`
+
+			while (true) {
+				while (next < chunkMatches.size() && chunkMatches[next].indecies.start < from)
+					next++;
+
+				// the thread's scan passed through `from` if it was not inside one of the thread's matches
+				if (from <= chunkBegin(i) || next == 0 || chunkMatches[next - 1].indecies.end <= from) {
+					matches.insert(matches.end(), chunkMatches.begin() + next, chunkMatches.end());
+					break;
+				}
+
+				FSMResult match = this->_simulate_longest_substring<ExecMode, EntryT>(input, scan, from, chunkEnd(i));
+
+				if (-not match.accepted)
+					break;
+
+				from = match.indecies.end;
+				matches.push_back(match);
+			}
+
+		}
+
+		return matches;
+	}
 
 	/**
-	* @brief Simulate the given input string using the given simulation method.
+	* @brief Simulate every input of `inputs` using the given simulation method and write the result of `inputs[i]` into `results[i]`.
+	* Whole-string and longest-prefix simulations advance BATCH_LANES inputs in lockstep, one character each per round.
+	* The lanes are independent chains of table loads, so the loads of one lane overlap with the others instead of waiting on each other.
+	* The row each lane needs next is prefetched, and a lane that finishes its input takes the next input of the batch.
+	* `StringT` is InputT or std::string_view, so a batch of views into one buffer needs no owning strings.
 	*/
 	template<typename TransFuncT, typename InputT>
-	inline FSMResult DeterFiniteAutomatan<TransFuncT, InputT>::simulate(const InputT& input, FSM_MODE mode) const
+	template<typename EntryT, typename StringT>
+	void DeterFiniteAutomatan<TransFuncT, InputT>::_simulate_batch(std::span<const StringT> inputs, FSM_MODE mode, std::span<FSMResult> results) const
 	{
+		constexpr FSM_EXEC_MODE ExecMode = FSM_EXEC_MODE::EM_PREMULTIPLIED;
+		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+
+		if (results.size() < inputs.size()) {
+			LoggerInfo loggerInfo = {
+				  .level = LOG_LEVEL::LL_ERROR,
+				  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+			};
+			const std::string message = "DeterFiniteAutomatan: the results span is smaller than the inputs span.";
+			this->m_Logger.log(loggerInfo, message);
+			throw std::invalid_argument(message);
+		}
+
 		switch (mode) {
 		case FSM_MODE::MM_WHOLE_STRING:
-			return this->_simulate_whole_string(input);
 		case FSM_MODE::MM_LONGEST_PREFIX:
-			return this->_simulate_longest_prefix(input);
+			break;
 		case FSM_MODE::MM_LONGEST_SUBSTRING:
-			return this->_simulate_longest_substring(input);
+		{
+			// the attempts of a substring search are already interleaved within each input
+			SubstringScan scan = this->_substring_scan();
+			for (size_t i = 0; i < inputs.size(); i++) {
+				results[i] = this->_simulate_longest_substring<ExecMode, EntryT>(inputs[i], scan);
+			}
+			return;
+		}
 		default:
 			std::cerr << "Unreachable: simulate() cannot reach this point." << std::endl;
-			// TODO: throw a better exception
 			throw std::runtime_error("The provided mode is erroneous in function DFA::simulate().");
 		}
 
+		const bool wholeString = mode == FSM_MODE::MM_WHOLE_STRING;
+		const EntryT* table = m_ClassTable.as<EntryT>().data();
+
+		struct Lane {
+			size_t inputIndex = 0;
+			size_t charIndex = 0;
+			state_t state = DEAD_STATE;
+			state_t lastFinalState = DEAD_STATE;
+			size_t lastFinalIndex = 0;
+		};
+
+		std::array<Lane, BATCH_LANES> lanes;
+		size_t activeLanes = 0, nextInput = 0;
+
+		// give the lane the next input of the batch, if any
+		auto load = [&](Lane& lane) -> bool {
+			if (nextInput == inputs.size())
+				return false;
+
+			lane = Lane{ nextInput++, 0, this->_start_state<ExecMode>(), DEAD_STATE, 0 };
+			return true;
+		};
+
+		// write the result of the lane's input
+		auto finish = [&](const Lane& lane) {
+			FSMResult& res = results[lane.inputIndex];
+			res.input = inputs[lane.inputIndex];
+
+			if (wholeString) {
+				res.accepted = lane.charIndex == inputs[lane.inputIndex].size() && this->_is_final<ExecMode>(lane.state);
+				res.finalState = res.accepted ? this->_state_id<ExecMode>(lane.state) : startState;
+				res.indecies = { 0, res.accepted ? lane.charIndex : 0 };
+			}
+			else {
+				res.accepted = lane.lastFinalIndex > 0;
+				res.finalState = res.accepted ? this->_state_id<ExecMode>(lane.lastFinalState) : startState;
+				res.indecies = { 0, lane.lastFinalIndex };
+			}
+		};
+
+		while (activeLanes < BATCH_LANES && load(lanes[activeLanes]))
+			activeLanes++;
+
+		while (activeLanes) {
+
+			for (size_t l = 0; l < activeLanes; ) {
+				Lane& lane = lanes[l];
+				const std::string_view input = inputs[lane.inputIndex];
+
+				if (lane.charIndex < input.size()) {
+					lane.state = table[lane.state + m_ByteClasses[(unsigned char)input[lane.charIndex]]];
+
+					if (lane.state != DEAD_STATE) {
+						lane.charIndex++;
+
+						if (this->_is_final<ExecMode>(lane.state)) {
+							lane.lastFinalState = lane.state;
+							lane.lastFinalIndex = lane.charIndex;
+						}
+
+						// prefetch the entry this lane loads in the next round
+						if (lane.charIndex < input.size())
+							FSM_PREFETCH(table + lane.state + m_ByteClasses[(unsigned char)input[lane.charIndex]]);
+
+						l++;
+						continue;
+					}
+				}
+
+				// the lane is done: report it and refill it, or retire it by moving the last active lane into its place
+				finish(lane);
+
+				if (-not load(lane))
+					lane = lanes[--activeLanes];
+			}
+
+		}
+
 	}
 
 }
\ No newline at end of file
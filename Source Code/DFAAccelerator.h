@@ -0,0 +1,93 @@
+#pragma once
+
+#include "FiniteStateMachine.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define FSM_ACCEL_SSE2 1
+#else
+#define FSM_ACCEL_SSE2 0
+#endif
+
+namespace m0st4fa {
+
+	/**
+	* @brief Skips over the run of bytes on which a state moves to itself.
+	* A state is accelerated when it leaves itself on at most ACCEL_BYTE_MAX bytes (its exit bytes),
+	* optionally together with every byte that has its high bit set (a table narrower than 256 inputs sends those to the dead state).
+	* Inside such a state a DFA would spend one table load per byte to go nowhere; skip() finds the next exit byte 16 bytes at a time instead.
+	*/
+	struct DFAAccelerator {
+		static constexpr size_t ACCEL_BYTE_MAX = 3;
+
+		// the exit bytes; unused slots repeat the first exit byte
+		std::array<unsigned char, ACCEL_BYTE_MAX> exitBytes{};
+		unsigned char exitCount = 0;
+		// every byte >= 0x80 is an exit byte too
+		bool exitsOnHighBytes = false;
+
+		bool isExit(unsigned char c) const {
+			if (exitsOnHighBytes && c >= 0x80)
+				return true;
+
+			for (size_t i = 0; i < exitCount; i++)
+				if (exitBytes[i] == c)
+					return true;
+
+			return false;
+		};
+
+		/**
+		* @brief Return the index of the first exit byte in `data[begin, end)`, or `end` if there is none.
+		*/
+		size_t skip(const char* data, size_t begin, size_t end) const {
+			size_t i = begin;
+
+			// a state that never leaves itself consumes the rest of the input
+			if (exitCount == 0 && -not exitsOnHighBytes)
+				return end;
+
+			// a single exit byte is what memchr is for
+			if (exitCount == 1 && -not exitsOnHighBytes) {
+				const void* found = std::memchr(data + i, exitBytes[0], end - i);
+				return found ? (size_t)((const char*)found - data) : end;
+			}
+
+#if FSM_ACCEL_SSE2
+			const __m128i b0 = _mm_set1_epi8((char)exitBytes[0]);
+			const __m128i b1 = _mm_set1_epi8((char)exitBytes[1]);
+			const __m128i b2 = _mm_set1_epi8((char)exitBytes[2]);
+			// the high bit of a byte is its sign bit, so movemask over the raw bytes flags the high bytes
+			const int highMask = exitsOnHighBytes ? 0xFFFF : 0;
+			const int lowMask = exitCount ? 0xFFFF : 0;
+
+			for (; i + 16 <= end; i += 16) {
+				const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+				const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, b0), _mm_cmpeq_epi8(chunk, b1)), _mm_cmpeq_epi8(chunk, b2));
+				const int mask = (_mm_movemask_epi8(hits) & lowMask) | (_mm_movemask_epi8(chunk) & highMask);
+
+				if (mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+					unsigned long bit;
+					_BitScanForward(&bit, (unsigned long)mask);
+					return i + bit;
+#else
+					return i + (size_t)__builtin_ctz((unsigned)mask);
+#endif
+				}
+			}
+#endif
+
+			for (; i < end; i++)
+				if (isExit((unsigned char)data[i]))
+					return i;
+
+			return end;
+		};
+	};
+
+}
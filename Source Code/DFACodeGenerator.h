@@ -0,0 +1,239 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "DFA.h"
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	// the largest machine whose generated substring search keeps its attempt lists in per-thread storage; larger ones allocate them on the heap
+	constexpr size_t GENERATED_TLS_STATE_MAX = 256;
+
+	/**
+	* @brief Return the source of a standalone C++ header that implements `dfa` as direct-coded states instead of table lookups.
+	* The header depends only on the standard library (<vector> only above GENERATED_TLS_STATE_MAX states) and declares everything in namespace `name`:
+	* `matchWholeString()`, `matchLongestPrefix()` and `matchLongestSubstring()` (and `match()`, which dispatches on a `Mode`)
+	* return the same acceptance, final state and match offsets as DeterFiniteAutomatan::simulate() in the corresponding FSM_MODE.
+	* Whole-string and longest-prefix matching jump from state to state with `goto`; every state is a `switch` over the next byte.
+	* Only the states reachable from the start state are emitted.
+	*/
+	template <typename TransFuncT, typename InputT>
+	std::string generateDFASource(const DeterFiniteAutomatan<TransFuncT, InputT>&, const std::string& name);
+
+	/**
+	* @brief Write the source generated by generateDFASource() to the file at `path`.
+	*/
+	template <typename TransFuncT, typename InputT>
+	void writeDFASource(const DeterFiniteAutomatan<TransFuncT, InputT>&, const std::string& name, const std::string& path);
+
+
+	// IMPLEMENTATIONS
+	template <typename TransFuncT, typename InputT>
+	std::string generateDFASource(const DeterFiniteAutomatan<TransFuncT, InputT>& dfa, const std::string& name)
+	{
+		constexpr state_t DEAD_STATE = 0;
+		constexpr state_t START_STATE = 1;
+
+		const TransFuncT& transFn = dfa.getTransitionFunction();
+		const state_set_t& finalStates = dfa.getFinalStates();
+		const size_t inputMax = std::min<size_t>(transFn.m_InputMax, BYTE_COUNT);
+
+		auto target = [&](state_t state, size_t b) -> state_t {
+			return state < transFn.m_StateMax && b < inputMax ? (state_t)transFn(state, b) : DEAD_STATE;
+		};
+
+		// collect the live states reachable from the start state, in the order they are found
+		std::vector<state_t> states;
+		std::vector<bool> seen(std::max<size_t>(transFn.m_StateMax, START_STATE + 1), false);
+		seen[DEAD_STATE] = seen[START_STATE] = true;
+		states.push_back(START_STATE);
+
+		for (size_t i = 0; i < states.size(); i++)
+			for (size_t b = 0; b < BYTE_COUNT; b++) {
+				state_t next = target(states[i], b);
+				if (next >= seen.size())
+					seen.resize(next + 1, false);
+				if (-not seen[next]) {
+					seen[next] = true;
+					states.push_back(next);
+				}
+			}
+
+		const size_t stateCount = seen.size();
+		const bool threadLocalAttempts = stateCount <= GENERATED_TLS_STATE_MAX;
+
+		auto caseLabel = [](size_t b) {
+			if (b >= 0x20 && b < 0x7F && b != '\'' && b != '\\')
+				return std::string{ "case '" } + (char)b + "':";
+			return "case " + std::to_string(b) + ":";
+		};
+
+		/**
+		* Emit a switch over the byte `c` that ends every case with `action(target)`.
+		* The most common target is the default case, so that each state lists only the bytes that differ from it.
+		*/
+		auto emitSwitch = [&](std::ostringstream& out, state_t state, const std::string& indent, auto action) {
+			std::map<state_t, std::vector<size_t>> bytesOf;
+			for (size_t b = 0; b < BYTE_COUNT; b++)
+				bytesOf[target(state, b)].push_back(b);
+
+			state_t common = bytesOf.begin()->first;
+			for (const auto& [next, bytes] : bytesOf)
+				if (bytes.size() > bytesOf[common].size())
+					common = next;
+
+			out << indent << "switch (c) {\n";
+			for (const auto& [next, bytes] : bytesOf) {
+				if (next == common)
+					continue;
+
+				out << indent;
+				for (size_t i = 0; i < bytes.size(); i++)
+					out << (i ? " " : "") << caseLabel(bytes[i]);
+				out << " " << action(next) << "\n";
+			}
+			out << indent << "default: " << action(common) << "\n";
+			out << indent << "}\n";
+		};
+
+		auto isFinal = [&](state_t state) { return finalStates.contains(state); };
+
+		std::ostringstream out;
+
+		out << "// Generated by m0st4fa::generateDFASource(); do not edit.\n"
+			<< "#pragma once\n\n"
+			<< "#include <cstddef>\n"
+			<< "#include <string_view>\n"
+			<< (threadLocalAttempts ? "" : "#include <vector>\n") << "\n"
+			<< "namespace " << name << " {\n\n"
+			<< "\t// the modes of m0st4fa::FSM_MODE\n"
+			<< "\tenum class Mode {\n\t\tWholeString = 0,\n\t\tLongestPrefix,\n\t\tLongestSubstring,\n\t};\n\n"
+			<< "\t// the fields of m0st4fa::FSMResult\n"
+			<< "\tstruct Result {\n\t\tbool accepted = false;\n\t\tunsigned finalState = " << START_STATE << ";\n"
+			<< "\t\tstd::size_t start = 0;\n\t\tstd::size_t end = 0;\n\t};\n\n"
+			<< "\tconstexpr unsigned STATE_COUNT = " << stateCount << ";\n\n";
+
+		// next() and isFinal(), used by the substring search
+		out << "\tinline unsigned next(unsigned state, unsigned char c) {\n\t\tswitch (state) {\n";
+		for (state_t state : states) {
+			out << "\t\tcase " << state << ":\n";
+			emitSwitch(out, state, "\t\t\t", [](state_t next) { return "return " + std::to_string(next) + ";"; });
+		}
+		out << "\t\tdefault:\n\t\t\treturn " << DEAD_STATE << ";\n\t\t}\n\t}\n\n";
+
+		out << "\tinline bool isFinal(unsigned state) {\n\t\tswitch (state) {\n";
+		if (std::any_of(states.begin(), states.end(), isFinal)) {
+			out << "\t\t";
+			for (state_t state : states)
+				if (isFinal(state))
+					out << "case " << state << ": ";
+			out << "\n\t\t\treturn true;\n";
+		}
+		out << "\t\tdefault:\n\t\t\treturn false;\n\t\t}\n\t}\n\n";
+
+		// the dead-state label is only emitted when some state jumps to it, since an unused label is a warning
+		bool deadUsed = false;
+		auto jump = [&deadUsed](state_t next) {
+			deadUsed = deadUsed || next == DEAD_STATE;
+			return "goto S" + std::to_string(next) + ";";
+		};
+
+		// whole-string mode
+		out << "\tinline Result matchWholeString(std::string_view input) {\n"
+			<< "\t\tstd::size_t i = 0;\n\t\tunsigned char c;\n\n\t\tgoto S" << START_STATE << ";\n\n";
+		for (state_t state : states) {
+			out << "\tS" << state << ":\n\t\tif (i == input.size())\n\t\t\treturn ";
+			if (isFinal(state))
+				out << "Result{ true, " << state << ", 0, i };\n";
+			else
+				out << "Result{};\n";
+			out << "\t\tc = (unsigned char)input[i++];\n";
+			emitSwitch(out, state, "\t\t", jump);
+			out << "\n";
+		}
+		if (deadUsed)
+			out << "\tS" << DEAD_STATE << ":\n\t\treturn Result{};\n";
+		out << "\t}\n\n";
+
+		// longest-prefix mode
+		out << "\tinline Result matchLongestPrefix(std::string_view input) {\n"
+			<< "\t\tstd::size_t i = 0, lastEnd = 0;\n\t\tunsigned lastFinal = " << START_STATE << ";\n\t\tunsigned char c;\n\n\t\tgoto S" << START_STATE << ";\n\n";
+		for (state_t state : states) {
+			out << "\tS" << state << ":\n";
+			if (isFinal(state))
+				out << "\t\tif (i > 0)\n\t\t\tlastFinal = " << state << ", lastEnd = i;\n";
+			out << "\t\tif (i == input.size())\n\t\t\tgoto S" << DEAD_STATE << ";\n"
+				<< "\t\tc = (unsigned char)input[i++];\n";
+			emitSwitch(out, state, "\t\t", jump);
+			out << "\n";
+		}
+		out << "\tS" << DEAD_STATE << ":\n\t\treturn Result{ lastEnd > 0, lastEnd > 0 ? lastFinal : " << START_STATE << "u, 0, lastEnd };\n\t}\n\n";
+
+		// longest-substring mode: the leftmost-longest search of DeterFiniteAutomatan::simulate() over next()
+		out << "\tinline Result matchLongestSubstring(std::string_view input) {\n"
+			<< "\t\tconstexpr std::size_t NO_MATCH = (std::size_t)-1;\n"
+			<< "\t\tstruct Attempt {\n\t\t\tunsigned state;\n\t\t\tstd::size_t start;\n\t\t};\n\n"
+			<< "\t\t// an attempt owns the states it reaches, so there are never more attempts than states\n";
+		if (threadLocalAttempts)
+			out << "\t\t// the lists are kept per thread rather than on the stack; the claims of earlier calls belong to older generations\n"
+				<< "\t\tstatic thread_local Attempt attempts[2][STATE_COUNT];\n"
+				<< "\t\tstatic thread_local std::size_t claimed[STATE_COUNT], lastGeneration = 0;\n"
+				<< "\t\tstd::size_t generation = lastGeneration + 1;\n";
+		else
+			out << "\t\tstd::vector<Attempt> attempts[2] = { std::vector<Attempt>(STATE_COUNT), std::vector<Attempt>(STATE_COUNT) };\n"
+				<< "\t\tstd::vector<std::size_t> claimed(STATE_COUNT, 0);\n"
+				<< "\t\tstd::size_t generation = 1;\n";
+		out << "\t\tstd::size_t counts[2] = { 0, 0 };\n"
+			<< "\t\tint curr = 0;\n\t\tstd::size_t matchStart = NO_MATCH, matchEnd = 0;\n\t\tunsigned matchState = " << START_STATE << ";\n\n"
+			<< "\t\tfor (std::size_t i = 0; i < input.size(); i++) {\n"
+			<< "\t\t\tif (matchStart == NO_MATCH && claimed[" << START_STATE << "] != generation) {\n"
+			<< "\t\t\t\tclaimed[" << START_STATE << "] = generation;\n"
+			<< "\t\t\t\tattempts[curr][counts[curr]++] = { " << START_STATE << ", i };\n\t\t\t}\n\n"
+			<< "\t\t\tgeneration++;\n\t\t\tcounts[1 - curr] = 0;\n\n"
+			<< "\t\t\tfor (std::size_t a = 0; a < counts[curr]; a++) {\n"
+			<< "\t\t\t\tconst Attempt attempt = attempts[curr][a];\n"
+			<< "\t\t\t\tif (matchStart != NO_MATCH && attempt.start > matchStart)\n\t\t\t\t\tbreak;\n\n"
+			<< "\t\t\t\tunsigned state = next(attempt.state, (unsigned char)input[i]);\n"
+			<< "\t\t\t\tif (state == " << DEAD_STATE << " || claimed[state] == generation)\n\t\t\t\t\tcontinue;\n\n"
+			<< "\t\t\t\tclaimed[state] = generation;\n"
+			<< "\t\t\t\tattempts[1 - curr][counts[1 - curr]++] = { state, attempt.start };\n\n"
+			<< "\t\t\t\tif (isFinal(state) && (matchStart == NO_MATCH || attempt.start <= matchStart))\n"
+			<< "\t\t\t\t\tmatchStart = attempt.start, matchEnd = i + 1, matchState = state;\n\t\t\t}\n\n"
+			<< "\t\t\tcurr = 1 - curr;\n"
+			<< "\t\t\tif (counts[curr] == 0 && matchStart != NO_MATCH)\n\t\t\t\tbreak;\n\t\t}\n\n"
+			<< (threadLocalAttempts ? "\t\tlastGeneration = generation;\n\n" : "")
+			<< "\t\tif (matchStart == NO_MATCH)\n\t\t\treturn Result{};\n\n"
+			<< "\t\treturn Result{ true, matchState, matchStart, matchEnd };\n\t}\n\n";
+
+		out << "\tinline Result match(std::string_view input, Mode mode) {\n\t\tswitch (mode) {\n"
+			<< "\t\tcase Mode::WholeString:\n\t\t\treturn matchWholeString(input);\n"
+			<< "\t\tcase Mode::LongestPrefix:\n\t\t\treturn matchLongestPrefix(input);\n"
+			<< "\t\tdefault:\n\t\t\treturn matchLongestSubstring(input);\n\t\t}\n\t}\n\n"
+			<< "}\n";
+
+		return out.str();
+	}
+
+	template <typename TransFuncT, typename InputT>
+	void writeDFASource(const DeterFiniteAutomatan<TransFuncT, InputT>& dfa, const std::string& name, const std::string& path)
+	{
+		std::ofstream file{ path, std::ios::trunc };
+
+		if (-not (file << generateDFASource(dfa, name))) {
+			LoggerInfo loggerInfo = {
+				  .level = LOG_LEVEL::LL_ERROR,
+				  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+			};
+			const std::string message = "writeDFASource: cannot write \"" + path + "\".";
+			Logger{}.log(loggerInfo, message);
+			throw std::runtime_error(message);
+		}
+	}
+
+}
@@ -0,0 +1,52 @@
+// std includes
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+// my includes
+#include "GeneratedDFAs.h"
+#include "DFACodeGenerator.h"
+#include "DFASerializer.h"
+
+/**
+* Writes the direct-coded matchers of DFAs as a build step, before the code that includes them is compiled (RegEx2 runs it as its pre-build event):
+*	<program> <output directory>
+*		writes <output directory>/<name>.h for every DFA of GENERATED_DFAS;
+*	<program> <saved DFA> <namespace> <output header>
+*		writes the matcher of a DFA saved by DFASerializer::save(), so any table a program can build can be generated.
+*/
+int main(int argc, char** argv) {
+	if (argc != 2 && argc != 4) {
+		std::cerr << "usage: " << argv[0] << " <output directory>\n"
+			<< "       " << argv[0] << " <saved DFA> <namespace> <output header>\n";
+		return 1;
+	}
+
+	try {
+		if (argc == 2) {
+			const std::filesystem::path directory = argv[1];
+			std::filesystem::create_directories(directory);
+
+			for (const m0st4fa::GeneratedDFA& dfa : m0st4fa::GENERATED_DFAS)
+				m0st4fa::writeDFASource(dfa.build(), dfa.name, (directory / (dfa.name + ".h")).string());
+
+			return 0;
+		}
+
+		const std::string name = argv[2];
+		auto isIdentifierChar = [](char c) { return std::isalnum((unsigned char)c) || c == '_'; };
+
+		if (name.empty() || std::isdigit((unsigned char)name[0]) || -not std::all_of(name.begin(), name.end(), isIdentifierChar)) {
+			std::cerr << "the namespace \"" << name << "\" is not an identifier\n";
+			return 1;
+		}
+
+		auto automaton = m0st4fa::DFASerializer::load(argv[1]);
+		m0st4fa::writeDFASource(automaton, name, argv[3]);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+}
@@ -0,0 +1,399 @@
+#include "DFAJit.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace m0st4fa {
+
+	namespace {
+
+		constexpr size_t NO_LABEL = (size_t)-1;
+		constexpr state_t DEAD_STATE = 0;
+
+		// above this many compare-and-branch ranges, a state dispatches through a jump table instead
+		constexpr size_t MAX_BRANCH_RANGES = 6;
+
+		// condition codes of the near Jcc opcodes (0F 8x)
+		constexpr unsigned char CC_B = 0x82;
+		constexpr unsigned char CC_E = 0x84;
+		constexpr unsigned char CC_NE = 0x85;
+		constexpr unsigned char CC_BE = 0x86;
+
+		/**
+		* @brief A tiny x86-64 assembler: raw bytes, labels, and 32-bit displacements that are patched once every label is bound.
+		*/
+		class Assembler {
+			struct Fixup {
+				size_t at;
+				size_t label;
+				// the displacement is taken from this label; NO_LABEL means from the end of the displacement, as branches do
+				size_t base;
+			};
+
+			std::vector<unsigned char> m_Code;
+			std::vector<size_t> m_Labels;
+			std::vector<Fixup> m_Fixups;
+
+		public:
+			size_t newLabel() {
+				m_Labels.push_back(NO_LABEL);
+				return m_Labels.size() - 1;
+			};
+			void bind(size_t label) { m_Labels[label] = m_Code.size(); };
+			size_t offset() const { return m_Code.size(); };
+
+			void emit(std::initializer_list<unsigned char> bytes) { m_Code.insert(m_Code.end(), bytes); };
+			void imm32(std::uint32_t value) {
+				for (size_t i = 0; i < 4; i++)
+					m_Code.push_back((unsigned char)(value >> (8 * i)));
+			};
+			void disp32(size_t label, size_t base = NO_LABEL) {
+				m_Fixups.push_back({ m_Code.size(), label, base });
+				this->imm32(0);
+			};
+			void align(size_t alignment) {
+				while (m_Code.size() % alignment)
+					m_Code.push_back(0xCC); // int3
+			};
+
+			void jmp(size_t label) { this->emit({ 0xE9 }); this->disp32(label); };
+			void jcc(unsigned char cc, size_t label) { this->emit({ 0x0F, cc }); this->disp32(label); };
+
+			std::vector<unsigned char> link() {
+				for (const Fixup& fixup : m_Fixups) {
+					const size_t from = fixup.base == NO_LABEL ? fixup.at + 4 : m_Labels[fixup.base];
+					const std::uint32_t disp = (std::uint32_t)((std::int64_t)m_Labels[fixup.label] - (std::int64_t)from);
+
+					for (size_t i = 0; i < 4; i++)
+						m_Code[fixup.at + i] = (unsigned char)(disp >> (8 * i));
+				}
+
+				return std::move(m_Code);
+			};
+		};
+
+		struct Symbol {
+			size_t start, end;
+			std::string name;
+		};
+
+		/**
+		* Register use, common to both modes and restricted to registers that both the System V and the Windows x64 ABIs let a callee clobber:
+		*	r8  - the next byte to read		r9  - the end of the input		r11 - the start of the input
+		*	rax - the byte just read		rdx - the state reported		rcx - the end of the longest accepted prefix
+		*	r10 - scratch; the outcome pointer waits on the stack until the end
+		*/
+		void emitPrologue(Assembler& as) {
+#if defined(_WIN32)
+			// (data = rcx, size = rdx, outcome = r8)
+			as.emit({ 0x41, 0x50 });				// push r8
+			as.emit({ 0x49, 0x89, 0xCB });			// mov r11, rcx
+			as.emit({ 0x4C, 0x8D, 0x0C, 0x11 });	// lea r9, [rcx + rdx]
+			as.emit({ 0x49, 0x89, 0xC8 });			// mov r8, rcx
+#else
+			// (data = rdi, size = rsi, outcome = rdx)
+			as.emit({ 0x52 });						// push rdx
+			as.emit({ 0x49, 0x89, 0xFB });			// mov r11, rdi
+			as.emit({ 0x4C, 0x8D, 0x0C, 0x37 });	// lea r9, [rdi + rsi]
+			as.emit({ 0x49, 0x89, 0xF8 });			// mov r8, rdi
+#endif
+		}
+
+		// store rax as the end and rdx as the state, and return
+		void emitEpilogue(Assembler& as) {
+			as.emit({ 0x41, 0x5A });				// pop r10
+			as.emit({ 0x4C, 0x29, 0xD8 });			// sub rax, r11
+			as.emit({ 0x49, 0x89, 0x02 });			// mov [r10], rax
+			as.emit({ 0x49, 0x89, 0x52, 0x08 });	// mov [r10 + 8], rdx
+			as.emit({ 0xC3 });						// ret
+		}
+
+		/**
+		* Branch on the byte in al to the label of its target.
+		* The most common target is the fall-through `jmp`; the other targets are tested as ranges of consecutive bytes,
+		* unless there are too many of them, in which case the byte indexes a table of 32-bit offsets placed right after the code.
+		*/
+		void emitDispatch(Assembler& as, const state_t* row, const std::vector<size_t>& labelOf) {
+			struct Range {
+				size_t from, to;
+				state_t target;
+			};
+
+			std::vector<Range> ranges;
+			std::vector<size_t> weight(labelOf.size(), 0);
+
+			for (size_t b = 0; b < BYTE_COUNT; b++) {
+				if (ranges.empty() || ranges.back().target != row[b])
+					ranges.push_back({ b, b, row[b] });
+				else
+					ranges.back().to = b;
+				weight[row[b]]++;
+			}
+
+			state_t common = row[0];
+			for (const Range& range : ranges)
+				if (weight[range.target] > weight[common])
+					common = range.target;
+
+			size_t branchRanges = 0;
+			for (const Range& range : ranges)
+				branchRanges += range.target != common;
+
+			if (branchRanges <= MAX_BRANCH_RANGES) {
+				for (const Range& range : ranges) {
+					if (range.target == common)
+						continue;
+
+					if (range.from == range.to) {
+						as.emit({ 0x3C, (unsigned char)range.from });	// cmp al, from
+						as.jcc(CC_E, labelOf[range.target]);
+						continue;
+					}
+
+					size_t next = as.newLabel();
+					if (range.from > 0) {
+						as.emit({ 0x3C, (unsigned char)range.from });	// cmp al, from
+						as.jcc(CC_B, next);
+					}
+					as.emit({ 0x3C, (unsigned char)range.to });			// cmp al, to
+					as.jcc(CC_BE, labelOf[range.target]);
+					as.bind(next);
+				}
+
+				as.jmp(labelOf[common]);
+				return;
+			}
+
+			size_t table = as.newLabel();
+			as.emit({ 0x4C, 0x8D, 0x15 });			// lea r10, [rip + table]
+			as.disp32(table);
+			as.emit({ 0x49, 0x63, 0x04, 0x82 });	// movsxd rax, dword [r10 + rax * 4]
+			as.emit({ 0x4C, 0x01, 0xD0 });			// add rax, r10
+			as.emit({ 0xFF, 0xE0 });				// jmp rax
+
+			as.align(4);
+			as.bind(table);
+			for (size_t b = 0; b < BYTE_COUNT; b++)
+				as.disp32(labelOf[row[b]], table);
+		}
+
+		/**
+		* Whole-string matching: run to the end of the input and report the state reached there, or the dead state as soon as it is reached.
+		*/
+		void emitWholeString(Assembler& as, const std::vector<state_t>& targets, const std::vector<state_t>& states, const std::string& name, std::vector<Symbol>& symbols) {
+			const size_t finish = as.newLabel(), dead = as.newLabel();
+
+			std::vector<size_t> labelOf(targets.size() / BYTE_COUNT, NO_LABEL);
+			for (state_t state : states)
+				labelOf[state] = as.newLabel();
+			labelOf[DEAD_STATE] = dead;
+
+			size_t start = as.offset();
+			emitPrologue(as);
+			as.jmp(labelOf[states.front()]);
+			symbols.push_back({ start, as.offset(), name + "::whole" });
+
+			for (state_t state : states) {
+				start = as.offset();
+				as.bind(labelOf[state]);
+
+				size_t body = as.newLabel();
+				as.emit({ 0x4D, 0x39, 0xC8 });			// cmp r8, r9
+				as.jcc(CC_NE, body);
+				as.emit({ 0xBA });						// mov edx, state
+				as.imm32(state);
+				as.jmp(finish);
+
+				as.bind(body);
+				as.emit({ 0x41, 0x0F, 0xB6, 0x00 });	// movzx eax, byte [r8]
+				as.emit({ 0x49, 0x83, 0xC0, 0x01 });	// add r8, 1
+				emitDispatch(as, &targets[state * BYTE_COUNT], labelOf);
+
+				symbols.push_back({ start, as.offset(), name + "::whole::S" + std::to_string(state) });
+			}
+
+			start = as.offset();
+			as.bind(dead);
+			as.emit({ 0x31, 0xD2 });					// xor edx, edx
+			as.bind(finish);
+			as.emit({ 0x4C, 0x89, 0xC0 });				// mov rax, r8
+			emitEpilogue(as);
+			symbols.push_back({ start, as.offset(), name + "::whole::finish" });
+		}
+
+		/**
+		* Longest-prefix matching: entering a final state remembers it together with the input position;
+		* the end of the input or the dead state reports the last one remembered.
+		*/
+		void emitLongestPrefix(Assembler& as, const std::vector<state_t>& targets, const std::vector<bool>& finals, const std::vector<state_t>& states, const std::string& name, std::vector<Symbol>& symbols) {
+			const size_t finish = as.newLabel();
+
+			std::vector<size_t> labelOf(targets.size() / BYTE_COUNT, NO_LABEL);
+			for (state_t state : states)
+				labelOf[state] = as.newLabel();
+			labelOf[DEAD_STATE] = finish;
+
+			size_t start = as.offset();
+			emitPrologue(as);
+			as.emit({ 0x4C, 0x89, 0xD9 });				// mov rcx, r11
+			as.emit({ 0xBA });							// mov edx, start state
+			as.imm32(states.front());
+			as.jmp(labelOf[states.front()]);
+			symbols.push_back({ start, as.offset(), name + "::prefix" });
+
+			for (state_t state : states) {
+				start = as.offset();
+				as.bind(labelOf[state]);
+
+				// a final state at the start of the input is an empty prefix, which is reported as no match anyway
+				if (finals[state]) {
+					as.emit({ 0x4C, 0x89, 0xC1 });		// mov rcx, r8
+					as.emit({ 0xBA });					// mov edx, state
+					as.imm32(state);
+				}
+
+				as.emit({ 0x4D, 0x39, 0xC8 });			// cmp r8, r9
+				as.jcc(CC_E, finish);
+				as.emit({ 0x41, 0x0F, 0xB6, 0x00 });	// movzx eax, byte [r8]
+				as.emit({ 0x49, 0x83, 0xC0, 0x01 });	// add r8, 1
+				emitDispatch(as, &targets[state * BYTE_COUNT], labelOf);
+
+				symbols.push_back({ start, as.offset(), name + "::prefix::S" + std::to_string(state) });
+			}
+
+			start = as.offset();
+			as.bind(finish);
+			as.emit({ 0x48, 0x89, 0xC8 });				// mov rax, rcx
+			emitEpilogue(as);
+			symbols.push_back({ start, as.offset(), name + "::prefix::finish" });
+		}
+
+#if !defined(_WIN32)
+		// perf looks for the map of a process at this path; Windows profilers have no such convention, so nothing is written there
+		void writePerfMap(const unsigned char* base, const std::vector<Symbol>& symbols) {
+			const std::string path = "/tmp/perf-" + std::to_string((int)getpid()) + ".map";
+
+			// the map is only a profiling aid, so a failure to write it is ignored
+			std::FILE* file = std::fopen(path.c_str(), "a");
+			if (file == nullptr)
+				return;
+
+			for (const Symbol& symbol : symbols)
+				std::fprintf(file, "%llx %llx %s\n", (unsigned long long)(base + symbol.start), (unsigned long long)(symbol.end - symbol.start), symbol.name.c_str());
+
+			std::fclose(file);
+		}
+#endif
+
+	}
+
+	DFAJitCode::DFAJitCode(const std::vector<state_t>& targets, const std::vector<bool>& finals, const std::vector<state_t>& states, const std::string& name, bool perfMap)
+	{
+#if FSM_JIT_X64
+		Assembler as;
+		std::vector<Symbol> symbols;
+
+		const size_t wholeString = as.offset();
+		emitWholeString(as, targets, states, name, symbols);
+		as.align(16);
+		const size_t longestPrefix = as.offset();
+		emitLongestPrefix(as, targets, finals, states, name, symbols);
+
+		std::vector<unsigned char> code = as.link();
+
+		LoggerInfo loggerInfo = {
+			  .level = LOG_LEVEL::LL_ERROR,
+			  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+		};
+
+		auto fail = [&](const std::string& reason) {
+			const std::string message = "DFAJitCode: cannot allocate executable memory: " + reason;
+			_release();
+			m_Logger.log(loggerInfo, message);
+			throw std::runtime_error(message);
+		};
+
+		// write the code, then turn the mapping read-only and executable, so it is never writable and executable at once
+#if defined(_WIN32)
+		m_Memory = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		if (m_Memory == nullptr)
+			fail("VirtualAlloc failed with error " + std::to_string(GetLastError()));
+		m_MemorySize = code.size();
+
+		std::memcpy(m_Memory, code.data(), code.size());
+
+		DWORD oldProtection = 0;
+		if (-not VirtualProtect(m_Memory, m_MemorySize, PAGE_EXECUTE_READ, &oldProtection))
+			fail("VirtualProtect failed with error " + std::to_string(GetLastError()));
+		FlushInstructionCache(GetCurrentProcess(), m_Memory, m_MemorySize);
+#else
+		void* memory = ::mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+			fail(std::strerror(errno));
+		m_Memory = memory;
+		m_MemorySize = code.size();
+
+		std::memcpy(m_Memory, code.data(), code.size());
+
+		if (::mprotect(m_Memory, m_MemorySize, PROT_READ | PROT_EXEC) < 0)
+			fail(std::strerror(errno));
+#endif
+
+		m_WholeString = (EntryT)((unsigned char*)m_Memory + wholeString);
+		m_LongestPrefix = (EntryT)((unsigned char*)m_Memory + longestPrefix);
+
+#if !defined(_WIN32)
+		if (perfMap)
+			writePerfMap((const unsigned char*)m_Memory, symbols);
+#endif
+#endif
+	}
+
+	DFAJitCode::DFAJitCode(DFAJitCode&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	DFAJitCode& DFAJitCode::operator=(DFAJitCode&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		_release();
+
+		m_Memory = std::exchange(other.m_Memory, nullptr);
+		m_MemorySize = std::exchange(other.m_MemorySize, 0);
+		m_WholeString = std::exchange(other.m_WholeString, nullptr);
+		m_LongestPrefix = std::exchange(other.m_LongestPrefix, nullptr);
+
+		return *this;
+	}
+
+	void DFAJitCode::_release()
+	{
+		if (m_Memory) {
+#if defined(_WIN32)
+			VirtualFree(m_Memory, 0, MEM_RELEASE);
+#else
+			::munmap(m_Memory, m_MemorySize);
+#endif
+		}
+
+		m_Memory = nullptr;
+		m_MemorySize = 0;
+		m_WholeString = m_LongestPrefix = nullptr;
+	}
+
+}
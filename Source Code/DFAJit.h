@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Logger.h"
+#include "DFA.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FSM_JIT_X64 1
+#else
+#define FSM_JIT_X64 0
+#endif
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	/**
+	* @brief Native x86-64 code for a DFA over bytes, held in an executable mapping that is written once and then made read-only.
+	* Every live state is a block of code: it checks for the end of the input, loads the next byte and branches to the block of the next state,
+	* with a chain of compare-and-branch pairs when the state leaves its most common target on a few byte ranges and a jump table otherwise.
+	* There is one entry point for whole-string matching and one for longest-prefix matching.
+	*
+	* With `perfMap` set, the blocks are appended to /tmp/perf-<pid>.map so that `perf report` attributes samples to states; no map is written on Windows.
+	* Where FSM_JIT_X64 is 0, nothing is compiled and isCompiled() is false.
+	*/
+	class DFAJitCode {
+	public:
+		// what the generated code reports: the state it stopped in and the number of bytes up to it
+		struct Outcome {
+			std::uint64_t end = 0;
+			std::uint64_t state = 0;
+		};
+
+	private:
+		using EntryT = void (*)(const unsigned char*, size_t, Outcome*);
+
+		void* m_Memory = nullptr;
+		size_t m_MemorySize = 0;
+		EntryT m_WholeString = nullptr;
+		EntryT m_LongestPrefix = nullptr;
+
+		Logger m_Logger;
+
+		void _release();
+
+	public:
+		DFAJitCode() = default;
+		/**
+		* `targets` holds BYTE_COUNT targets for each state and `states` the live states, the start state first.
+		*/
+		DFAJitCode(const std::vector<state_t>& targets, const std::vector<bool>& finals, const std::vector<state_t>& states, const std::string& name, bool perfMap);
+		DFAJitCode(const DFAJitCode&) = delete;
+		DFAJitCode& operator=(const DFAJitCode&) = delete;
+		DFAJitCode(DFAJitCode&&) noexcept;
+		DFAJitCode& operator=(DFAJitCode&&) noexcept;
+		~DFAJitCode() { _release(); };
+
+		bool isCompiled() const { return m_Memory != nullptr; };
+		size_t getCodeSize() const { return m_MemorySize; };
+
+		Outcome runWholeString(std::string_view input) const {
+			Outcome outcome;
+			m_WholeString((const unsigned char*)input.data(), input.size(), &outcome);
+			return outcome;
+		};
+		Outcome runLongestPrefix(std::string_view input) const {
+			Outcome outcome;
+			m_LongestPrefix((const unsigned char*)input.data(), input.size(), &outcome);
+			return outcome;
+		};
+	};
+
+	/**
+	* @brief Runs a DFA as native code (see DFAJitCode), reporting the same results as DeterFiniteAutomatan::simulate().
+	* Whole-string and longest-prefix matching are compiled; longest-substring matching, and every mode on a machine that is not x86-64,
+	* is handed to the automaton's own simulate(). The automaton must outlive the JIT.
+	*/
+	template <typename TransFuncT, typename InputT = std::string>
+	class DFAJit {
+		using AutomatonT = DeterFiniteAutomatan<TransFuncT, InputT>;
+
+		constexpr static state_t DEAD_STATE = 0;
+		constexpr static state_t START_STATE = 1;
+
+		const AutomatonT* m_Automaton = nullptr;
+		std::vector<bool> m_Finals;
+		DFAJitCode m_Code;
+
+	public:
+		/**
+		* @param name names the code in the perf map, as `<name>::whole::S<state>` and so on.
+		* @param perfMap whether to append the code to the perf map; off by default, since the map is left behind in /tmp.
+		*/
+		DFAJit(const AutomatonT&, const std::string& name = "dfa", bool perfMap = false);
+
+		FSMResult simulate(std::string_view, FSM_MODE) const;
+		FSMResult simulate(std::span<const std::byte> input, FSM_MODE mode) const { return this->simulate(toStringView(input), mode); };
+
+		// whether native code is used; if not, every call goes to the interpreter
+		bool isCompiled() const { return m_Code.isCompiled(); };
+		size_t getCodeSize() const { return m_Code.getCodeSize(); };
+	};
+
+
+	// IMPLEMENTATIONS
+	template<typename TransFuncT, typename InputT>
+	DFAJit<TransFuncT, InputT>::DFAJit(const AutomatonT& automaton, const std::string& name, bool perfMap) :
+		m_Automaton{ &automaton }
+	{
+		const TransFuncT& transFn = automaton.getTransitionFunction();
+		const state_set_t& finalStates = automaton.getFinalStates();
+		const size_t stateMax = std::max<size_t>(transFn.m_StateMax, START_STATE + 1);
+		const size_t inputMax = std::min<size_t>(transFn.m_InputMax, BYTE_COUNT);
+
+		// the whole table over bytes; bytes outside of it go to the dead state
+		std::vector<state_t> targets(stateMax * BYTE_COUNT, DEAD_STATE);
+		for (state_t state = 0; state < transFn.m_StateMax; state++)
+			for (size_t b = 0; b < inputMax; b++)
+				targets[state * BYTE_COUNT + b] = (state_t)transFn(state, b);
+
+		// the live states reachable from the start state; targets past the table are dead
+		std::vector<bool> seen(stateMax, false);
+		std::vector<state_t> states{ START_STATE };
+		seen[DEAD_STATE] = seen[START_STATE] = true;
+
+		for (size_t i = 0; i < states.size(); i++)
+			for (size_t b = 0; b < BYTE_COUNT; b++) {
+				state_t& next = targets[states[i] * BYTE_COUNT + b];
+				if (next >= stateMax)
+					next = DEAD_STATE;
+
+				if (-not seen[next]) {
+					seen[next] = true;
+					states.push_back(next);
+				}
+			}
+
+		m_Finals.assign(stateMax, false);
+		for (state_t state : finalStates)
+			if (state < stateMax)
+				m_Finals[state] = true;
+
+		m_Code = DFAJitCode{ targets, m_Finals, states, name, perfMap };
+	}
+
+	template<typename TransFuncT, typename InputT>
+	FSMResult DFAJit<TransFuncT, InputT>::simulate(std::string_view input, FSM_MODE mode) const
+	{
+		if (-not m_Code.isCompiled())
+			return m_Automaton->simulate(input, mode);
+
+		switch (mode) {
+		case FSM_MODE::MM_WHOLE_STRING: {
+			DFAJitCode::Outcome outcome = m_Code.runWholeString(input);
+			bool accepted = m_Finals[outcome.state];
+			return FSMResult(accepted, accepted ? (state_t)outcome.state : START_STATE, { 0, accepted ? input.size() : 0 }, input);
+		}
+		case FSM_MODE::MM_LONGEST_PREFIX: {
+			DFAJitCode::Outcome outcome = m_Code.runLongestPrefix(input);
+			bool accepted = outcome.end > 0;
+			return FSMResult(accepted, accepted ? (state_t)outcome.state : START_STATE, { 0, (size_t)outcome.end }, input);
+		}
+		default:
+			return m_Automaton->simulate(input, mode);
+		}
+	}
+
+}
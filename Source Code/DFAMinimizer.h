@@ -0,0 +1,287 @@
+#pragma once
+
+#include "DFA.h"
+#include <algorithm>
+#include <map>
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	// whether the entries of the table can be assigned through `table[state][input]`
+	template <typename TableT>
+	constexpr bool is_writable_table_v = std::is_assignable_v<decltype(std::declval<TableT&>()[0][0]), state_t>;
+
+	/**
+	* The transition function of the DFA minimize() returns: the input's own, unless its table is read-only
+	* (such as the FSMTableView of a DFA loaded by DFASerializer::load()), in which case the minimal table is built into an FSMDynamicTable.
+	*/
+	template <typename TransFuncT>
+	using minimized_trans_fn_t = std::conditional_t<is_writable_table_v<decltype(TransFuncT{}.m_Function)>, TransFuncT, TransitionFunction<FSMDynamicTable<state_t>>>;
+
+	/**
+	* @brief Return a DFA equivalent to `dfa` with the least number of states, using Hopcroft's partition refinement.
+	* States that are unreachable from the start state are dropped, and states that cannot reach a final state merge into the dead state.
+	* 
+	* Token factories map final states to tokens, so final states keep their identity:
+	* a final state is merged only with final states of the same group in `tokenGroups`, and a merged group is known by its smallest id.
+	* Final states that are not in any group are never merged and keep their own ids.
+	* The start state keeps id 1 and the dead state keeps id 0; the remaining states are renumbered.
+	* The result has the table type of `dfa`, or an FSMDynamicTable if that type is read-only (see minimized_trans_fn_t).
+	*/
+	template <typename TransFuncT, typename InputT>
+	DeterFiniteAutomatan<minimized_trans_fn_t<TransFuncT>, InputT> minimize(const DeterFiniteAutomatan<TransFuncT, InputT>&, const std::vector<state_set_t>& tokenGroups = {});
+
+
+	// IMPLEMENTATIONS
+	template <typename TransFuncT, typename InputT>
+	DeterFiniteAutomatan<minimized_trans_fn_t<TransFuncT>, InputT> minimize(const DeterFiniteAutomatan<TransFuncT, InputT>& dfa, const std::vector<state_set_t>& tokenGroups)
+	{
+		using ResultTransFuncT = minimized_trans_fn_t<TransFuncT>;
+		using TableT = decltype(ResultTransFuncT{}.m_Function);
+		constexpr state_t DEAD_STATE = 0;
+		constexpr state_t START_STATE = 1;
+		constexpr size_t NO_BLOCK = (size_t)-1;
+
+		const TransFuncT& transFn = dfa.getTransitionFunction();
+		const state_set_t& finalStates = dfa.getFinalStates();
+		const size_t stateCount = std::max<size_t>(transFn.m_StateMax, START_STATE + 1);
+		const size_t inputMax = std::min<size_t>(transFn.m_InputMax, BYTE_COUNT);
+
+		// work over byte classes instead of bytes; bytes outside of the table go to the dead state
+		const ByteClassMap& byteClasses = dfa.getByteClasses();
+		const size_t classCount = dfa.getClassCount();
+		std::vector<size_t> representative(classCount);
+		for (size_t b = BYTE_COUNT; b-- > 0; )
+			representative[byteClasses[b]] = b;
+
+		auto target = [&](state_t state, size_t cls) -> state_t {
+			size_t b = representative[cls];
+			return state < transFn.m_StateMax && b < inputMax ? (state_t)transFn(state, b) : DEAD_STATE;
+		};
+
+		// keep only the states reachable from the start state (and the dead state)
+		std::vector<bool> reachable(stateCount, false);
+		std::vector<state_t> stack = { DEAD_STATE, START_STATE };
+		reachable[DEAD_STATE] = reachable[START_STATE] = true;
+
+		while (stack.size()) {
+			state_t state = stack.back();
+			stack.pop_back();
+
+			for (size_t cls = 0; cls < classCount; cls++) {
+				state_t next = target(state, cls);
+
+				if (-not reachable.at(next)) {
+					reachable[next] = true;
+					stack.push_back(next);
+				}
+			}
+		}
+
+		/**
+		* The initial partition: one block for the non-final states, one block per token group and one block per other final state.
+		* The partition is kept as a permutation of the states in which every block is a contiguous range.
+		* While splitting, the marked states of a block are moved to the front of its range.
+		*/
+		std::vector<size_t> blockOf(stateCount, NO_BLOCK);
+		std::vector<state_t> elements;
+		std::vector<size_t> location(stateCount);
+		std::vector<size_t> first, last, markedEnd;
+
+		auto isFinal = [&](state_t state) { return state != DEAD_STATE && finalStates.contains(state); };
+
+		{
+			std::map<size_t, size_t> groupOf; // final state -> token group
+			for (size_t g = 0; g < tokenGroups.size(); g++)
+				for (state_t s : tokenGroups[g])
+					groupOf.emplace(s, g);
+
+			// key: 0 for non-final states, 1 + group for grouped final states and 1 + groups + id for the others
+			std::map<size_t, std::vector<state_t>> initial;
+			for (state_t s = 0; s < stateCount; s++) {
+				if (-not reachable[s])
+					continue;
+
+				size_t key = 0;
+				if (isFinal(s)) {
+					auto it = groupOf.find(s);
+					key = 1 + (it != groupOf.end() ? it->second : tokenGroups.size() + s);
+				}
+
+				initial[key].push_back(s);
+			}
+
+			for (auto& [key, members] : initial) {
+				first.push_back(elements.size());
+
+				for (state_t s : members) {
+					blockOf[s] = first.size() - 1;
+					location[s] = elements.size();
+					elements.push_back(s);
+				}
+
+				last.push_back(elements.size());
+				markedEnd.push_back(first.back());
+			}
+		}
+
+		// predecessors of every state on every class, for the reachable states
+		std::vector<std::vector<state_t>> predecessors(classCount * stateCount);
+		for (state_t s = 0; s < stateCount; s++)
+			if (reachable[s])
+				for (size_t cls = 0; cls < classCount; cls++)
+					predecessors[cls * stateCount + target(s, cls)].push_back(s);
+
+		// refine the partition until no splitter divides a block
+		std::vector<size_t> worklist;
+		std::vector<bool> inWorklist(first.size(), true);
+		for (size_t b = 0; b < first.size(); b++)
+			worklist.push_back(b);
+
+		std::vector<size_t> touched;
+
+		while (worklist.size()) {
+			size_t splitter = worklist.back();
+			worklist.pop_back();
+			inWorklist[splitter] = false;
+
+			// the splitter may be split while it is processed, so take a copy of its states
+			std::vector<state_t> splitterStates(elements.begin() + first[splitter], elements.begin() + last[splitter]);
+
+			for (size_t cls = 0; cls < classCount; cls++) {
+
+				// mark every state that moves into the splitter on this class
+				for (state_t t : splitterStates)
+					for (state_t s : predecessors[cls * stateCount + t]) {
+						size_t b = blockOf[s];
+						size_t i = location[s];
+
+						if (i < markedEnd[b])
+							continue;
+
+						if (markedEnd[b] == first[b])
+							touched.push_back(b);
+
+						// swap the state to the end of the marked part of its block
+						state_t other = elements[markedEnd[b]];
+						std::swap(elements[i], elements[markedEnd[b]]);
+						location[other] = i;
+						location[s] = markedEnd[b];
+						markedEnd[b]++;
+					}
+
+				// split every block that is only partially marked
+				for (size_t b : touched) {
+					if (markedEnd[b] == last[b]) {
+						markedEnd[b] = first[b];
+						continue;
+					}
+
+					// the marked part becomes a new block
+					size_t newBlock = first.size();
+					first.push_back(first[b]);
+					last.push_back(markedEnd[b]);
+					markedEnd.push_back(first[b]);
+					inWorklist.push_back(false);
+
+					first[b] = markedEnd[b];
+					markedEnd[b] = first[b];
+
+					for (size_t i = first[newBlock]; i < last[newBlock]; i++)
+						blockOf[elements[i]] = newBlock;
+
+					// if the block is waiting to be a splitter, both halves must be; otherwise the smaller half suffices
+					if (inWorklist[b] || last[newBlock] - first[newBlock] <= last[b] - first[b]) {
+						worklist.push_back(newBlock);
+						inWorklist[newBlock] = true;
+					}
+					else {
+						worklist.push_back(b);
+						inWorklist[b] = true;
+					}
+				}
+
+				touched.clear();
+			}
+		}
+
+		/**
+		* Number the blocks of the minimal machine.
+		* The dead block is 0, the start block is 1 and final blocks are known by their smallest final state.
+		* The other blocks take the smallest ids that are still free.
+		*/
+		const size_t blockCount = first.size();
+		std::vector<state_t> idOf(blockCount, DEAD_STATE);
+		std::vector<bool> idUsed = { true, true };
+		auto use = [&idUsed](state_t id) {
+			if (id >= idUsed.size())
+				idUsed.resize(id + 1, false);
+			idUsed[id] = true;
+		};
+
+		const size_t deadBlock = blockOf[DEAD_STATE];
+		const size_t startBlock = blockOf[START_STATE];
+
+		for (size_t b = 0; b < blockCount; b++) {
+			state_t smallest = *std::min_element(elements.begin() + first[b], elements.begin() + last[b]);
+
+			if (b == startBlock && b != deadBlock)
+				idOf[b] = START_STATE;
+			else if (b != deadBlock && isFinal(smallest)) {
+				idOf[b] = smallest;
+				use(smallest);
+			}
+		}
+
+		state_t nextId = START_STATE + 1;
+		for (size_t b = 0; b < blockCount; b++) {
+			if (b == deadBlock || b == startBlock || isFinal(elements[first[b]]))
+				continue;
+
+			while (nextId < idUsed.size() && idUsed[nextId])
+				nextId++;
+
+			idOf[b] = nextId;
+			use(nextId);
+		}
+
+		/**
+		* A machine needs at least one final state; if none is reachable, keep the smallest one as an unreachable state.
+		* Its row and the start row (if the start state is dead) stay dead.
+		*/
+		state_t unreachableFinal = DEAD_STATE;
+		if (std::none_of(elements.begin(), elements.end(), isFinal) && finalStates.size()) {
+			unreachableFinal = *std::min_element(finalStates.begin(), finalStates.end());
+			use(unreachableFinal);
+		}
+
+		// build the minimal table
+		const size_t newStateCount = idUsed.size();
+		TableT table{};
+		if constexpr (std::is_constructible_v<TableT, size_t, size_t>)
+			table = TableT(newStateCount, transFn.m_InputMax);
+		else if (newStateCount > table.size())
+			throw std::length_error("minimize: the minimal machine does not fit in the table type.");
+
+		state_set_t newFinalStates;
+		if (unreachableFinal != DEAD_STATE)
+			newFinalStates.insert(unreachableFinal);
+
+		for (size_t b = 0; b < blockCount; b++) {
+			if (b == deadBlock)
+				continue;
+
+			state_t s = elements[first[b]];
+			state_t id = idOf[b];
+
+			if (isFinal(s))
+				newFinalStates.insert(id);
+
+			for (size_t in = 0; in < inputMax; in++)
+				table[id][in] = idOf[blockOf[s < transFn.m_StateMax ? (state_t)transFn(s, in) : DEAD_STATE]];
+		}
+
+		return DeterFiniteAutomatan<ResultTransFuncT, InputT>{ newFinalStates, ResultTransFuncT{ table }, dfa.getFlags() };
+	}
+
+}
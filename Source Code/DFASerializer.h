@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include "DFA.h"
+#include "MappedFile.h"
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	/**
+	* @brief Saves compiled DFAs to files and loads them back by mapping the file, without recompiling or parsing.
+	*
+	* The file is a header followed by sections, each aligned to SECTION_ALIGNMENT bytes:
+	* the transition table, the final states, the byte classes, the class table, the state ids of its rows and the accelerators.
+	* Sections are located by their offset from the start of the file, so the file can be mapped at any address.
+	* The header records the format version, the byte order and the sizes of the stored types; a file that does not match the running build is rejected.
+	* The class table is stored at the width it was compiled to (1, 2 or 4 bytes per entry) and is loaded at that width.
+	*
+	* A loaded DFA views the mapping directly: with the default FSMTableView table even its transition function points into the file,
+	* so processes that load the same file share one copy of it in the page cache.
+	* Loading only checks that the file is consistent, so that a corrupt file cannot make the unchecked simulation read outside the tables.
+	*/
+	class DFASerializer {
+
+		static constexpr char MAGIC[8] = { 'M', '0', 'D', 'F', 'A', '\r', '\n', '\0' };
+		static constexpr std::uint32_t ENDIAN_TAG = 0x01020304;
+		static constexpr size_t SECTION_ALIGNMENT = 64;
+
+		struct Section {
+			std::uint64_t offset = 0;
+			std::uint64_t count = 0;
+		};
+
+		struct Header {
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t endianTag;
+			std::uint32_t stateSize;
+			std::uint32_t acceleratorSize;
+			std::uint32_t classEntrySize;
+			std::uint32_t reserved;
+			std::uint64_t flags;
+			std::uint64_t stateMax;
+			std::uint64_t inputMax;
+			std::uint64_t rowCount;
+			std::uint64_t classCount;
+			std::uint64_t startState;
+			std::uint64_t finalStart;
+			std::uint64_t accelStart;
+			std::uint64_t accelEnd;
+			std::uint64_t hasStartSkip;
+			Section transitionTable;
+			Section finalStates;
+			Section byteClasses;
+			Section classTable;
+			Section stateIds;
+			Section accelerators;
+			Section startSkip;
+		};
+
+		[[noreturn]] static void _fail(const std::string& path, const std::string& reason);
+		static const void* _section(const MappedFile&, const Section&, size_t elementSize, size_t alignment, const std::string& path);
+
+	public:
+		// version 2 stores the class table at its compiled width
+		static constexpr std::uint32_t FORMAT_VERSION = 2;
+
+		template <typename TransFuncT, typename InputT>
+		static void save(const DeterFiniteAutomatan<TransFuncT, InputT>&, const std::string& path);
+
+		template <typename TableT = FSMTableView<state_t>, typename InputT = std::string>
+		static DeterFiniteAutomatan<TransitionFunction<TableT>, InputT> load(const std::string& path);
+	};
+
+
+	// IMPLEMENTATIONS
+	inline void DFASerializer::_fail(const std::string& path, const std::string& reason)
+	{
+		LoggerInfo loggerInfo = {
+			  .level = LOG_LEVEL::LL_ERROR,
+			  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+		};
+		const std::string message = "DFASerializer: \"" + path + "\": " + reason;
+		Logger{}.log(loggerInfo, message);
+		throw std::runtime_error(message);
+	}
+
+	// return the start of the section after checking that it lies inside the file
+	inline const void* DFASerializer::_section(const MappedFile& file, const Section& section, size_t elementSize, size_t alignment, const std::string& path)
+	{
+		if (section.count == 0)
+			return nullptr;
+
+		if (section.offset % alignment != 0 || section.offset > file.size() || section.count > (file.size() - section.offset) / elementSize)
+			_fail(path, "a section lies outside of the file.");
+
+		return file.data() + section.offset;
+	}
+
+	/**
+	* @brief Write the compiled form of `automaton` to the file at `path`, replacing the file.
+	*/
+	template <typename TransFuncT, typename InputT>
+	void DFASerializer::save(const DeterFiniteAutomatan<TransFuncT, InputT>& automaton, const std::string& path)
+	{
+		const TransFuncT& transFn = automaton.m_TransitionFunc;
+		const size_t stateMax = transFn.m_StateMax, inputMax = transFn.m_InputMax;
+
+		std::vector<state_t> transitionTable;
+		transitionTable.reserve(stateMax * inputMax);
+		for (state_t state = 0; state < stateMax; state++)
+			for (size_t input = 0; input < inputMax; input++)
+				transitionTable.push_back((state_t)transFn(state, input));
+
+		// final states past the last row are never reached, and load() rejects them
+		std::vector<state_t> finalStates;
+		for (state_t state : automaton.getFinalStates())
+			if (state < automaton.m_ClassTable.stateCount())
+				finalStates.push_back(state);
+		std::sort(finalStates.begin(), finalStates.end());
+
+		Header header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = FORMAT_VERSION;
+		header.endianTag = ENDIAN_TAG;
+		header.stateSize = sizeof(state_t);
+		header.acceleratorSize = sizeof(DFAAccelerator);
+		header.classEntrySize = (std::uint32_t)automaton.m_ClassTable.entrySize();
+		header.flags = automaton.getFlags();
+		header.stateMax = stateMax;
+		header.inputMax = inputMax;
+		header.rowCount = automaton.m_ClassTable.stateCount();
+		header.classCount = automaton.m_ClassTable.inputCount();
+		header.startState = automaton.m_StartState;
+		header.finalStart = automaton.m_FinalStart;
+		header.accelStart = automaton.m_AccelStart;
+		header.accelEnd = automaton.m_AccelEnd;
+		header.hasStartSkip = automaton.m_StartSkip.has_value();
+
+		// lay the sections out one after the other
+		size_t offset = sizeof(Header);
+		auto place = [&offset](Section& section, size_t count, size_t elementSize) {
+			offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+			section = { offset, count };
+			offset += count * elementSize;
+		};
+
+		place(header.transitionTable, transitionTable.size(), sizeof(state_t));
+		place(header.finalStates, finalStates.size(), sizeof(state_t));
+		place(header.byteClasses, BYTE_COUNT, sizeof(byte_class_t));
+		place(header.classTable, header.rowCount * header.classCount, header.classEntrySize);
+		place(header.stateIds, automaton.m_StateIds.size(), sizeof(state_t));
+		place(header.accelerators, automaton.m_Accelerators.size(), sizeof(DFAAccelerator));
+		place(header.startSkip, header.hasStartSkip, sizeof(DFAAccelerator));
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (-not file)
+			_fail(path, "the file cannot be opened for writing.");
+
+		auto write = [&file](const Section& section, const void* data, size_t elementSize) {
+			// pad up to the section
+			static const char padding[SECTION_ALIGNMENT] = {};
+			file.write(padding, (std::streamsize)(section.offset - (size_t)file.tellp()));
+			file.write((const char*)data, (std::streamsize)(section.count * elementSize));
+		};
+
+		file.write((const char*)&header, sizeof(Header));
+		write(header.transitionTable, transitionTable.data(), sizeof(state_t));
+		write(header.finalStates, finalStates.data(), sizeof(state_t));
+		write(header.byteClasses, automaton.m_ByteClasses.data(), sizeof(byte_class_t));
+		write(header.classTable, automaton.m_ClassTable.data(), header.classEntrySize);
+		write(header.stateIds, automaton.m_StateIds.data(), sizeof(state_t));
+		write(header.accelerators, automaton.m_Accelerators.data(), sizeof(DFAAccelerator));
+		if (header.hasStartSkip)
+			write(header.startSkip, &*automaton.m_StartSkip, sizeof(DFAAccelerator));
+
+		if (-not file)
+			_fail(path, "writing the file failed.");
+	}
+
+	/**
+	* @brief Map the file at `path` and return the DFA saved in it.
+	* With TableT = FSMTableView<state_t> nothing is copied; any other table type gets a copy of the transition function
+	* (it must be constructible from the dimensions, like FSMDynamicTable, or large enough by default, like FSMTable).
+	*/
+	template <typename TableT, typename InputT>
+	DeterFiniteAutomatan<TransitionFunction<TableT>, InputT> DFASerializer::load(const std::string& path)
+	{
+		using AutomatonT = DeterFiniteAutomatan<TransitionFunction<TableT>, InputT>;
+
+		auto file = std::make_shared<MappedFile>(path, MF_ACCESS::MA_NORMAL);
+
+		// check the header
+		Header header;
+		if (file->size() < sizeof(Header))
+			_fail(path, "the file is too short to be a DFA.");
+		std::memcpy(&header, file->data(), sizeof(Header));
+
+		if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+			_fail(path, "the file is not a DFA.");
+		if (header.endianTag != ENDIAN_TAG)
+			_fail(path, "the file was written with a different byte order.");
+		if (header.version != FORMAT_VERSION)
+			_fail(path, "the format version " + std::to_string(header.version) + " is not supported (expected " + std::to_string(FORMAT_VERSION) + ").");
+		if (header.stateSize != sizeof(state_t) || header.acceleratorSize != sizeof(DFAAccelerator))
+			_fail(path, "the file was written by a build with different type sizes.");
+		if (header.classEntrySize != sizeof(std::uint8_t) && header.classEntrySize != sizeof(std::uint16_t) && header.classEntrySize != sizeof(state_t))
+			_fail(path, "the class table entries have an unsupported width.");
+
+		const size_t rowCount = header.rowCount, classCount = header.classCount;
+
+		// bound the dimensions by their sections before multiplying them, so that a corrupt header cannot make the products wrap
+		if (classCount == 0 || classCount > BYTE_COUNT || rowCount == 0 || rowCount > header.classTable.count / classCount ||
+			header.inputMax > BYTE_COUNT || (header.inputMax != 0 && header.stateMax > header.transitionTable.count / header.inputMax))
+			_fail(path, "the section sizes are inconsistent.");
+
+		const size_t stateEnd = rowCount * classCount;
+
+		if (header.stateMax > rowCount || header.transitionTable.count != header.stateMax * header.inputMax ||
+			header.byteClasses.count != BYTE_COUNT || header.classTable.count != stateEnd || header.stateIds.count != rowCount ||
+			header.startSkip.count != header.hasStartSkip)
+			_fail(path, "the section sizes are inconsistent.");
+
+		auto sectionOf = [&]<typename T>(const Section& section, T*) {
+			return (const T*)_section(*file, section, sizeof(T), alignof(T), path);
+		};
+
+		const state_t* transitionTable = sectionOf(header.transitionTable, (state_t*)nullptr);
+		const state_t* finalStates = sectionOf(header.finalStates, (state_t*)nullptr);
+		const byte_class_t* byteClasses = sectionOf(header.byteClasses, (byte_class_t*)nullptr);
+		FSMPackedTableView classTable;
+		switch (header.classEntrySize) {
+		case sizeof(std::uint8_t):
+			classTable = FSMPackedTableView{ sectionOf(header.classTable, (std::uint8_t*)nullptr), rowCount, classCount };
+			break;
+		case sizeof(std::uint16_t):
+			classTable = FSMPackedTableView{ sectionOf(header.classTable, (std::uint16_t*)nullptr), rowCount, classCount };
+			break;
+		default:
+			classTable = FSMPackedTableView{ sectionOf(header.classTable, (state_t*)nullptr), rowCount, classCount };
+		}
+		const state_t* stateIds = sectionOf(header.stateIds, (state_t*)nullptr);
+		const DFAAccelerator* accelerators = sectionOf(header.accelerators, (DFAAccelerator*)nullptr);
+		const DFAAccelerator* startSkip = sectionOf(header.startSkip, (DFAAccelerator*)nullptr);
+
+		// every premultiplied state must be the start of a row
+		auto isState = [&](std::uint64_t state) { return state < stateEnd && state % classCount == 0; };
+		auto isBoundary = [&](std::uint64_t state) { return state <= stateEnd && state % classCount == 0; };
+
+		if (-not isState(header.startState) || -not isBoundary(header.finalStart) || -not isBoundary(header.accelStart) || -not isBoundary(header.accelEnd) ||
+			header.accelStart > header.finalStart || header.finalStart > header.accelEnd ||
+			header.accelerators.count != (header.accelEnd - header.accelStart) / classCount)
+			_fail(path, "the state layout is inconsistent.");
+
+		for (size_t i = 0; i < stateEnd; i++)
+			if (-not isState(classTable(0, i)))
+				_fail(path, "the class table moves to a state that does not exist.");
+
+		for (size_t b = 0; b < BYTE_COUNT; b++)
+			if (byteClasses[b] >= classCount)
+				_fail(path, "a byte is mapped to a class that does not exist.");
+
+		// the original ids are reported in results and index the transition function, so they must have rows too
+		auto isStateId = [&](state_t state) { return state < rowCount; };
+
+		if (-not std::all_of(stateIds, stateIds + rowCount, isStateId))
+			_fail(path, "a row has the id of a state that does not exist.");
+		if (-not std::all_of(finalStates, finalStates + header.finalStates.count, isStateId))
+			_fail(path, "a final state does not exist.");
+		if (-not std::all_of(transitionTable, transitionTable + header.transitionTable.count, isStateId))
+			_fail(path, "the transition function moves to a state that does not exist.");
+
+		// read the bytes of the accelerators before viewing them as such, since a bool holding anything but 0 or 1 is not a bool
+		for (size_t i = 0; i < header.accelerators.count + header.hasStartSkip; i++) {
+			const DFAAccelerator* accel = i < header.accelerators.count ? accelerators + i : startSkip;
+			unsigned char exitCount, exitsOnHighBytes;
+			std::memcpy(&exitCount, (const char*)accel + offsetof(DFAAccelerator, exitCount), sizeof(exitCount));
+			std::memcpy(&exitsOnHighBytes, (const char*)accel + offsetof(DFAAccelerator, exitsOnHighBytes), sizeof(exitsOnHighBytes));
+
+			if (exitCount > DFAAccelerator::ACCEL_BYTE_MAX || exitsOnHighBytes > 1)
+				_fail(path, "an accelerator is inconsistent.");
+		}
+
+		// build the transition function
+		TableT table{};
+		if constexpr (std::is_same_v<TableT, FSMTableView<state_t>>)
+			table = TableT{ transitionTable, header.stateMax, header.inputMax };
+		else {
+			if constexpr (std::is_constructible_v<TableT, size_t, size_t>)
+				table = TableT(header.stateMax, header.inputMax);
+			else if (header.stateMax > table.size() || (table.size() && header.inputMax > table.at(0).size()))
+				_fail(path, "the transition function does not fit in the table type.");
+
+			for (size_t state = 0; state < header.stateMax; state++)
+				for (size_t input = 0; input < header.inputMax; input++)
+					table[state][input] = transitionTable[state * header.inputMax + input];
+		}
+
+		AutomatonT automaton{ typename AutomatonT::Precompiled{}, state_set_t(finalStates, finalStates + header.finalStates.count), TransitionFunction<TableT>{ table }, (flag_t)header.flags };
+
+		// point the automaton at the compiled form in the file
+		std::memcpy(automaton.m_ByteClasses.data(), byteClasses, BYTE_COUNT);
+		automaton.m_ClassTable = classTable;
+		automaton.m_StateIds = std::span<const state_t>{ stateIds, rowCount };
+		automaton.m_Accelerators = std::span<const DFAAccelerator>{ accelerators, header.accelerators.count };
+		automaton.m_StartState = (state_t)header.startState;
+		automaton.m_FinalStart = (state_t)header.finalStart;
+		automaton.m_AccelStart = (state_t)header.accelStart;
+		automaton.m_AccelEnd = (state_t)header.accelEnd;
+		automaton.m_StartSkip = header.hasStartSkip ? std::optional<DFAAccelerator>{ *startSkip } : std::nullopt;
+		automaton.m_Storage = std::move(file);
+
+		return automaton;
+	}
+
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "DFA.h"
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	/**
+	* @brief Simulates a DFA over input that arrives in chunks, such as socket reads or file blocks.
+	* Feed the chunks in order with feed() and call finish() after the last one.
+	* The matcher keeps only the simulation state between chunks (the current state, the last accepting offset and the live attempts),
+	* never the chunks themselves, so a match may span any number of chunks without the input being concatenated.
+	* The result is the same as simulating the concatenated input with DeterFiniteAutomatan::simulate() in the same mode;
+	* its offsets count from the first byte fed, and its `input` is empty since the chunks are not kept.
+	* The automaton must outlive the matcher.
+	*/
+	template <typename TransFuncT, typename InputT = std::string>
+	class DFAStreamMatcher {
+		using AutomatonT = DeterFiniteAutomatan<TransFuncT, InputT>;
+
+		// the matcher always steps through the premultiplied class table
+		constexpr static FSM_EXEC_MODE ExecMode = FSM_EXEC_MODE::EM_PREMULTIPLIED;
+		constexpr static state_t DEAD_STATE = 0;
+		constexpr static state_t START_STATE = 1;
+
+		// fields
+		const AutomatonT* m_Automaton = nullptr;
+		FSM_MODE m_Mode = FSM_MODE::MM_LONGEST_PREFIX;
+
+		size_t m_Offset = 0; // the number of bytes fed so far
+		// set once no further input can change the result
+		bool m_Done = false;
+
+		// whole-string and longest-prefix modes
+		state_t m_State = DEAD_STATE;
+		state_t m_LastFinalState = DEAD_STATE;
+		size_t m_LastFinalIndex = 0;
+
+		// longest-substring mode: the search of DeterFiniteAutomatan::_simulate_longest_substring(), carried from one chunk to the next
+		typename AutomatonT::SubstringScan m_Scan;
+
+		Logger m_Logger;
+
+		// private methods
+		// `EntryT` is the entry type of the automaton's class table
+		template <typename EntryT>
+		void _feed_whole_string(std::string_view);
+		template <typename EntryT>
+		void _feed_longest_prefix(std::string_view);
+		template <typename EntryT>
+		void _feed_longest_substring(std::string_view);
+
+	public:
+		DFAStreamMatcher(const AutomatonT&, FSM_MODE);
+
+		void feed(std::string_view);
+		void feed(std::span<const std::byte> chunk) { this->feed(toStringView(chunk)); };
+		FSMResult finish();
+		void reset();
+
+		// whether the result is settled, so that the remaining input need not be fed
+		bool done() const { return m_Done; };
+		size_t getOffset() const { return m_Offset; };
+	};
+
+
+	// IMPLEMENTATIONS
+	template<typename TransFuncT, typename InputT>
+	DFAStreamMatcher<TransFuncT, InputT>::DFAStreamMatcher(const AutomatonT& automaton, FSM_MODE mode) :
+		m_Automaton{ &automaton }, m_Mode{ mode }, m_Scan{ automaton._substring_scan() }
+	{
+
+		if (mode != FSM_MODE::MM_WHOLE_STRING && mode != FSM_MODE::MM_LONGEST_PREFIX && mode != FSM_MODE::MM_LONGEST_SUBSTRING) {
+			LoggerInfo loggerInfo = {
+				  .level = LOG_LEVEL::LL_ERROR,
+				  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+			};
+			const std::string message = "DFAStreamMatcher: the provided mode is erroneous.";
+			m_Logger.log(loggerInfo, message);
+			throw std::invalid_argument(message);
+		}
+
+		this->reset();
+	}
+
+	/**
+	* @brief Start over, as if nothing had been fed.
+	*/
+	template<typename TransFuncT, typename InputT>
+	void DFAStreamMatcher<TransFuncT, InputT>::reset()
+	{
+		m_Offset = 0;
+		m_Done = false;
+
+		m_State = m_Automaton->template _start_state<ExecMode>();
+		m_LastFinalState = DEAD_STATE;
+		m_LastFinalIndex = 0;
+
+		m_Scan.restart();
+	}
+
+	/**
+	* @brief Continue the simulation over the next chunk of the input.
+	* Chunks fed after the result is settled (see done()) are ignored.
+	*/
+	template<typename TransFuncT, typename InputT>
+	void DFAStreamMatcher<TransFuncT, InputT>::feed(std::string_view chunk)
+	{
+		if (m_Done)
+			return;
+
+		switch (m_Mode) {
+		case FSM_MODE::MM_WHOLE_STRING:
+			m_Automaton->_with_entry_type([&]<typename EntryT>() { this->_feed_whole_string<EntryT>(chunk); });
+			break;
+		case FSM_MODE::MM_LONGEST_PREFIX:
+			m_Automaton->_with_entry_type([&]<typename EntryT>() { this->_feed_longest_prefix<EntryT>(chunk); });
+			break;
+		case FSM_MODE::MM_LONGEST_SUBSTRING:
+			m_Automaton->_with_entry_type([&]<typename EntryT>() { this->_feed_longest_substring<EntryT>(chunk); });
+			break;
+		default:
+			std::cerr << "Unreachable: feed() cannot reach this point." << std::endl;
+			throw std::runtime_error("The provided mode is erroneous in function DFAStreamMatcher::feed().");
+		}
+
+		m_Offset += chunk.size();
+	}
+
+	template<typename TransFuncT, typename InputT>
+	template<typename EntryT>
+	void DFAStreamMatcher<TransFuncT, InputT>::_feed_whole_string(std::string_view chunk)
+	{
+		const AutomatonT& dfa = *m_Automaton;
+
+		for (size_t charIndex = 0; charIndex < chunk.size(); ) {
+			if (dfa._is_accelerated(m_State)) {
+				charIndex = dfa._accelerator(m_State).skip(chunk.data(), charIndex, chunk.size());
+
+				if (charIndex == chunk.size())
+					break;
+			}
+
+			m_State = dfa.template _next_state<ExecMode, EntryT>(m_State, chunk[charIndex++]);
+
+			// a dead state rejects the whole input, whatever follows
+			if (m_State == DEAD_STATE) {
+				m_Done = true;
+				return;
+			}
+		}
+
+	}
+
+	template<typename TransFuncT, typename InputT>
+	template<typename EntryT>
+	void DFAStreamMatcher<TransFuncT, InputT>::_feed_longest_prefix(std::string_view chunk)
+	{
+		const AutomatonT& dfa = *m_Automaton;
+
+		for (size_t charIndex = 0; charIndex < chunk.size(); charIndex++) {
+			if (dfa._is_accelerated(m_State)) {
+				size_t exitIndex = dfa._accelerator(m_State).skip(chunk.data(), charIndex, chunk.size());
+
+				if (exitIndex > charIndex && dfa.template _is_final<ExecMode>(m_State)) {
+					m_LastFinalState = m_State;
+					m_LastFinalIndex = m_Offset + exitIndex;
+				}
+
+				charIndex = exitIndex;
+				if (charIndex == chunk.size())
+					break;
+			}
+
+			m_State = dfa.template _next_state<ExecMode, EntryT>(m_State, chunk[charIndex]);
+
+			// the longest prefix cannot grow past a dead state
+			if (m_State == DEAD_STATE) {
+				m_Done = true;
+				return;
+			}
+
+			if (dfa.template _is_final<ExecMode>(m_State)) {
+				m_LastFinalState = m_State;
+				m_LastFinalIndex = m_Offset + charIndex + 1;
+			}
+		}
+
+	}
+
+	/**
+	* The attempts keep their start offsets from the first byte fed, so the chunk is scanned at offset m_Offset.
+	*/
+	template<typename TransFuncT, typename InputT>
+	template<typename EntryT>
+	void DFAStreamMatcher<TransFuncT, InputT>::_feed_longest_substring(std::string_view chunk)
+	{
+		if (m_Automaton->template _scan_longest_substring<ExecMode, EntryT>(chunk, m_Scan, 0, chunk.size(), m_Offset))
+			m_Done = true;
+	}
+
+	/**
+	* @brief End the input and return the result of the simulation.
+	* The matcher keeps its state, so finish() may be called again; call reset() to match a new input.
+	*/
+	template<typename TransFuncT, typename InputT>
+	FSMResult DFAStreamMatcher<TransFuncT, InputT>::finish()
+	{
+		const AutomatonT& dfa = *m_Automaton;
+
+		switch (m_Mode) {
+		case FSM_MODE::MM_WHOLE_STRING: {
+			bool accepted = m_State != DEAD_STATE && dfa.template _is_final<ExecMode>(m_State);
+			return FSMResult(accepted, accepted ? dfa.template _state_id<ExecMode>(m_State) : START_STATE, { 0, accepted ? m_Offset : 0 }, {});
+		}
+		case FSM_MODE::MM_LONGEST_PREFIX: {
+			bool accepted = m_LastFinalIndex > 0;
+			return FSMResult(accepted, accepted ? dfa.template _state_id<ExecMode>(m_LastFinalState) : START_STATE, { 0, m_LastFinalIndex }, {});
+		}
+		default:
+			if (m_Scan.matchStart == AutomatonT::SubstringScan::NO_MATCH)
+				return FSMResult(false, START_STATE, { 0, 0 }, {});
+
+			return FSMResult(true, dfa.template _state_id<ExecMode>(m_Scan.matchState), { m_Scan.matchStart, m_Scan.matchEnd }, {});
+		}
+
+	}
+
+}
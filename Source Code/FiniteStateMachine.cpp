@@ -4,24 +4,36 @@
 
 std::ostream& m0st4fa::operator<<(const std::ostream& os, const FSMResult& result)
 {
-	
+
+    printf("Accepted string: %s\nIndecies of the match: { %zu, %zu }\nFinal state reached: %u\n",
+        result.accepted ? "true" : "false", result.indecies.start, result.indecies.end, result.finalState);
+
+#ifdef _DEBUG
+    printf("Matched string: %.*s\n", (int)(result.indecies.end - result.indecies.start), result.input.data() + result.indecies.start);
+#endif
+
+    return std::cout;
+}
+
+std::ostream& m0st4fa::operator<<(const std::ostream& os, const FSMStateSetResult& result)
+{
+
     std::string temp = "{ ";
-    temp += std::to_string(*result.finalState.begin());
-    for (auto s : result.finalState) {
-        if (s == *result.finalState.begin())
+    temp += std::to_string(*result.finalStates.begin());
+    for (auto s : result.finalStates) {
+        if (s == *result.finalStates.begin())
             continue;
-		
+
         temp += (", " + std::to_string(s));
     }
     temp += " }";
-	
-    printf("Accepted string: %s\nIndecies of the match: { %u, %u }\nFinal states reached: %s\n", 
+
+    printf("Accepted string: %s\nIndecies of the match: { %zu, %zu }\nFinal states reached: %s\n",
         result.accepted ? "true" : "false", result.indecies.start, result.indecies.end, temp.data());
 
 #ifdef _DEBUG
-    printf("Matched string: %.*s\n", result.indecies.end - result.indecies.start, result.input.c_str() + result.indecies.start);
+    printf("Matched string: %.*s\n", (int)(result.indecies.end - result.indecies.start), result.input.data() + result.indecies.start);
 #endif
 
     return std::cout;
 }
-
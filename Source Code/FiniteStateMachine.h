@@ -4,7 +4,13 @@
 #include <unordered_set>
 #include <vector>
 #include <array>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <iostream>
 #include <source_location>
 #include <functional>
@@ -67,6 +73,15 @@ namespace m0st4fa {
 		MT_MACHINE_TYPE_MAX,
 	};
 
+	/**
+	* How a DFA steps through its transitions while simulating.
+	*/
+	enum class FSM_EXEC_MODE {
+		EM_CHECKED = 0,
+		EM_PREMULTIPLIED,
+		EM_EXEC_MODE_MAX,
+	};
+
 	enum FSM_FLAG {
 		//FF_CASE_INSENSITIVE,
 		//FF_CASE_SENSITIVE,
@@ -77,6 +92,180 @@ namespace m0st4fa {
 	template <size_t StateCount = 50, size_t InputCount = 'z'>
 	using FSMTable = std::array<std::array<state_t, InputCount>, StateCount>;
 
+	/**
+	* A transition table whose dimensions are chosen at runtime.
+	* The entries live in a single contiguous allocation laid out row after row (row-major), one row per state.
+	* Indexing mirrors FSMTable: `table[state][input]` and `table.at(state).at(input)`.
+	*/
+	template <typename EntryT = state_t>
+	class FSMDynamicTable {
+		size_t m_StateCount = 0;
+		size_t m_InputCount = 0;
+		std::vector<EntryT> m_Data;
+
+	public:
+		template <typename ElementT>
+		class RowView {
+			ElementT* m_Row = nullptr;
+			size_t m_Size = 0;
+
+		public:
+			RowView(ElementT* row, size_t size) : m_Row{ row }, m_Size{ size } {};
+
+			ElementT& operator[](size_t input) const { return m_Row[input]; };
+			ElementT& at(size_t input) const {
+				if (input >= m_Size)
+					throw std::out_of_range("FSMDynamicTable: input out of range.");
+
+				return m_Row[input];
+			};
+
+			size_t size() const { return m_Size; };
+			ElementT* begin() const { return m_Row; };
+			ElementT* end() const { return m_Row + m_Size; };
+		};
+
+		using Row = RowView<EntryT>;
+		using ConstRow = RowView<const EntryT>;
+
+		FSMDynamicTable() = default;
+		FSMDynamicTable(size_t stateCount, size_t inputCount, const EntryT& fill = EntryT{}) :
+			m_StateCount{ stateCount }, m_InputCount{ inputCount }, m_Data(stateCount * inputCount, fill)
+		{};
+
+		Row operator[](size_t state) { return Row{ m_Data.data() + state * m_InputCount, m_InputCount }; };
+		ConstRow operator[](size_t state) const { return ConstRow{ m_Data.data() + state * m_InputCount, m_InputCount }; };
+		Row at(size_t state) {
+			if (state >= m_StateCount)
+				throw std::out_of_range("FSMDynamicTable: state out of range.");
+
+			return (*this)[state];
+		};
+		ConstRow at(size_t state) const {
+			if (state >= m_StateCount)
+				throw std::out_of_range("FSMDynamicTable: state out of range.");
+
+			return (*this)[state];
+		};
+
+		// unchecked access to a single entry
+		EntryT& operator()(size_t state, size_t input) { return m_Data[state * m_InputCount + input]; };
+		const EntryT& operator()(size_t state, size_t input) const { return m_Data[state * m_InputCount + input]; };
+
+		/**
+		* `size()` is the number of states (rows), like the outer std::array of FSMTable.
+		*/
+		size_t size() const { return m_StateCount; };
+		size_t stateCount() const { return m_StateCount; };
+		size_t inputCount() const { return m_InputCount; };
+		bool empty() const { return m_Data.empty(); };
+		EntryT* data() { return m_Data.data(); };
+		const EntryT* data() const { return m_Data.data(); };
+	};
+
+	/**
+	* A read-only transition table over memory it does not own, such as a table mapped from a file (see DFASerializer.h).
+	* Laid out and indexed like FSMDynamicTable; the memory must outlive the view.
+	*/
+	template <typename EntryT = state_t>
+	class FSMTableView {
+		const EntryT* m_Data = nullptr;
+		size_t m_StateCount = 0;
+		size_t m_InputCount = 0;
+
+	public:
+		using ConstRow = typename FSMDynamicTable<EntryT>::ConstRow;
+
+		FSMTableView() = default;
+		FSMTableView(const EntryT* data, size_t stateCount, size_t inputCount) :
+			m_Data{ data }, m_StateCount{ stateCount }, m_InputCount{ inputCount }
+		{};
+		FSMTableView(const FSMDynamicTable<EntryT>& table) :
+			m_Data{ table.data() }, m_StateCount{ table.stateCount() }, m_InputCount{ table.inputCount() }
+		{};
+
+		ConstRow operator[](size_t state) const { return ConstRow{ m_Data + state * m_InputCount, m_InputCount }; };
+		ConstRow at(size_t state) const {
+			if (state >= m_StateCount)
+				throw std::out_of_range("FSMTableView: state out of range.");
+
+			return (*this)[state];
+		};
+
+		// unchecked access to a single entry
+		const EntryT& operator()(size_t state, size_t input) const { return m_Data[state * m_InputCount + input]; };
+
+		size_t size() const { return m_StateCount; };
+		size_t stateCount() const { return m_StateCount; };
+		size_t inputCount() const { return m_InputCount; };
+		bool empty() const { return m_StateCount * m_InputCount == 0; };
+		const EntryT* data() const { return m_Data; };
+	};
+
+	/**
+	* A read-only table laid out like FSMTableView whose entries are unsigned integers of 1, 2 or 4 bytes, the width being chosen at runtime.
+	* Code that walks the table picks the entry type once and views it with as<EntryT>(), rather than checking the width on every entry.
+	*/
+	class FSMPackedTableView {
+		const void* m_Data = nullptr;
+		size_t m_StateCount = 0;
+		size_t m_InputCount = 0;
+		size_t m_EntrySize = sizeof(state_t);
+
+	public:
+		template <typename EntryT>
+		static constexpr bool is_entry_type = std::is_same_v<EntryT, std::uint8_t> || std::is_same_v<EntryT, std::uint16_t> || std::is_same_v<EntryT, state_t>;
+
+		FSMPackedTableView() = default;
+		template <typename EntryT>
+		FSMPackedTableView(const EntryT* data, size_t stateCount, size_t inputCount) :
+			m_Data{ data }, m_StateCount{ stateCount }, m_InputCount{ inputCount }, m_EntrySize{ sizeof(EntryT) }
+		{
+			static_assert(is_entry_type<EntryT>, "FSMPackedTableView: the entries must be 1, 2 or 4 byte unsigned integers.");
+		};
+		template <typename EntryT>
+		FSMPackedTableView(const FSMDynamicTable<EntryT>& table) :
+			FSMPackedTableView{ table.data(), table.stateCount(), table.inputCount() }
+		{};
+
+		template <typename EntryT>
+		FSMTableView<EntryT> as() const {
+			if (sizeof(EntryT) != m_EntrySize)
+				throw std::logic_error("FSMPackedTableView: the table is not stored with this entry type.");
+
+			return FSMTableView<EntryT>{ static_cast<const EntryT*>(m_Data), m_StateCount, m_InputCount };
+		};
+
+		// unchecked access to a single entry, whatever its width; hot loops should use as<EntryT>() instead
+		state_t operator()(size_t state, size_t input) const {
+			const size_t index = state * m_InputCount + input;
+
+			switch (m_EntrySize) {
+			case sizeof(std::uint8_t):
+				return static_cast<const std::uint8_t*>(m_Data)[index];
+			case sizeof(std::uint16_t):
+				return static_cast<const std::uint16_t*>(m_Data)[index];
+			default:
+				return static_cast<const state_t*>(m_Data)[index];
+			}
+		};
+
+		size_t size() const { return m_StateCount; };
+		size_t stateCount() const { return m_StateCount; };
+		size_t inputCount() const { return m_InputCount; };
+		size_t entrySize() const { return m_EntrySize; };
+		bool empty() const { return m_StateCount * m_InputCount == 0; };
+		const void* data() const { return m_Data; };
+	};
+
+	/**
+	* Maps every byte to the id of its equivalence class.
+	* Two bytes are in the same class if every state of the automaton moves to the same state on both of them.
+	*/
+	typedef unsigned char byte_class_t;
+	constexpr size_t BYTE_COUNT = 256;
+	using ByteClassMap = std::array<byte_class_t, BYTE_COUNT>;
+
 	template <typename TableT = FSMTable<20, 'z'>>
 	struct TransitionFunction {
 		size_t m_StateMax = 0;
@@ -84,7 +273,8 @@ namespace m0st4fa {
 		TableT m_Function;
 		
 		TransitionFunction() = default;
-		TransitionFunction(const TableT& function) : m_Function(function), m_StateMax{ m_Function.size() }, m_InputMax{ m_Function.at(0).size() } {}
+		TransitionFunction(const TableT& function) : 
+			m_StateMax{ function.size() }, m_InputMax{ function.size() ? function.at(0).size() : 0 }, m_Function(function) {}
 
 		// TODO: add this overload
 		/*
@@ -96,6 +286,12 @@ namespace m0st4fa {
 			return m_Function.at(state).at(input);
 		}
 
+		// the entry itself rather than a copy, for callers that only read it (an NFA's entries are sets)
+		template <typename InputT>
+		const auto& entry(state_t state, InputT input) const {
+			return m_Function.at(state).at(input);
+		}
+
 		template <typename InputT>
 		auto operator()(state_set_t stateSet, InputT input) const {
 			state_set_t res;
@@ -119,7 +315,8 @@ namespace m0st4fa {
 	class FiniteStateMachine {
 
 		// friends
-		friend class FSMResult;
+		friend struct FSMResult;
+		friend struct FSMStateSetResult;
 		
 		// private instance data members
 		const state_set_t m_FinalStates{};
@@ -164,15 +361,43 @@ namespace m0st4fa {
 		FSM_TYPE getMachineType() const { return m_MachineType; };
 	};
 
+	/**
+	* The result of a simulation.
+	* `input` views the simulated input without owning it, and the match is the range [indecies.start, indecies.end) of it.
+	* The indices are size_t so that offsets into inputs (and mapped files) past 4 GiB survive on platforms where `long` is 32-bit.
+	* `finalState` is the final state the match ended in (the start state if nothing was accepted); token factories map it to a token.
+	* The result holds no heap memory, so returning one per match or per token costs no allocation.
+	*/
 	struct FSMResult {
 		bool accepted = false;
-		state_set_t finalState = { FiniteStateMachine<state_t>::START_STATE };
+		state_t finalState = FiniteStateMachine<state_t>::START_STATE;
 		struct {
-			unsigned long start = 0;
-			unsigned long end = 0;
+			size_t start = 0;
+			size_t end = 0;
 		} indecies;
-		const std::string& input;
+		std::string_view input;
 
 	};
 	std::ostream& operator<<(const std::ostream&, const FSMResult&);
+
+	/**
+	* The result of an NFA simulation that keeps every final state the match ended in.
+	* Only the simulateStateSet() of NonDeterFiniteAutomatan and its engines returns it; simulate() reports the smallest of these states in an FSMResult.
+	*/
+	struct FSMStateSetResult {
+		bool accepted = false;
+		state_set_t finalStates = { FiniteStateMachine<state_t>::START_STATE };
+		struct {
+			size_t start = 0;
+			size_t end = 0;
+		} indecies;
+		std::string_view input;
+
+	};
+	std::ostream& operator<<(const std::ostream&, const FSMStateSetResult&);
+
+	// view raw bytes, such as a network buffer, as the characters the automata consume
+	inline std::string_view toStringView(std::span<const std::byte> bytes) {
+		return std::string_view{ reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+	};
 };
\ No newline at end of file
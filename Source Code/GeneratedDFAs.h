@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+
+namespace m0st4fa {
+
+	using generated_dfa_t = DFA<TransFn<FSMDynamicTable<state_t>>>;
+
+	/**
+	* A DFA whose direct-coded matcher the build generates: DFAGenerator writes it to Generated/<name>.h, in namespace `name`.
+	*/
+	struct GeneratedDFA {
+		std::string name;
+		generated_dfa_t (*build)();
+	};
+
+	// the ab machine of the tests, which accepts aaa*b(a+b)*
+	inline generated_dfa_t abDFA() {
+		FSMDynamicTable<state_t> table{ 6, 'z' };
+
+		table[1]['a'] = 2;
+		table[2]['a'] = 3;
+		table[3]['a'] = 3;
+		table[3]['b'] = 4;
+		table[4]['a'] = 3;
+		table[4]['b'] = 5;
+		table[5]['a'] = 5;
+		table[5]['b'] = 5;
+
+		return generated_dfa_t{ state_set_t{ 4 }, TransFn<FSMDynamicTable<state_t>>{ table } };
+	}
+
+	// every DFA the build generates a matcher for
+	inline const std::vector<GeneratedDFA> GENERATED_DFAS = {
+		{ "ab_dfa", abDFA },
+	};
+
+}
@@ -136,7 +136,7 @@ namespace m0st4fa {
 
 		// get the lexeme and the final state reached (if any)
 		const FSMResult fsmRes = this->m_Automatan.simulate(this->m_SourceCode, FSM_MODE::MM_LONGEST_PREFIX);
-		const state_t fstate = *fsmRes.finalState.begin();
+		const state_t fstate = fsmRes.finalState;
 
 		// check whether there is a matched lexeme
 		if (-not fsmRes.accepted) {
@@ -193,7 +193,7 @@ namespace m0st4fa {
 
 		// get the lexeme and the final state reached (if any)
 		const FSMResult fsmRes = this->m_Automatan.simulate(this->m_SourceCode, FSM_MODE::MM_LONGEST_PREFIX);
-		const state_t fstate = *fsmRes.finalState.begin();
+		const state_t fstate = fsmRes.finalState;
 
 		// check whether there is a matched lexeme
 		if (-not fsmRes.accepted) {
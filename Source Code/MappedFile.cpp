@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace m0st4fa {
+
+	MappedFile::MappedFile(const std::string& path, MF_ACCESS access)
+	{
+		LoggerInfo loggerInfo = {
+			  .level = LOG_LEVEL::LL_ERROR,
+			  .info = {.errorType = ERROR_TYPE::ET_INVALID_ARGUMENT}
+		};
+
+		auto fail = [&](const std::string& reason) {
+			const std::string message = "MappedFile: cannot map \"" + path + "\": " + reason;
+			_unmap();
+			m_Logger.log(loggerInfo, message);
+			throw std::runtime_error(message);
+		};
+
+#if defined(_WIN32)
+		DWORD flags = FILE_ATTRIBUTE_NORMAL;
+		if (access == MF_ACCESS::MA_SEQUENTIAL)
+			flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+		else if (access == MF_ACCESS::MA_RANDOM)
+			flags |= FILE_FLAG_RANDOM_ACCESS;
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			fail("CreateFile failed with error " + std::to_string(GetLastError()));
+		m_File = file;
+
+		LARGE_INTEGER size{};
+		if (-not GetFileSizeEx(file, &size))
+			fail("GetFileSizeEx failed with error " + std::to_string(GetLastError()));
+
+		// an empty file cannot be mapped; it is viewed as an empty string
+		if (size.QuadPart == 0)
+			return;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+			fail("CreateFileMapping failed with error " + std::to_string(GetLastError()));
+		m_Mapping = mapping;
+
+		m_Data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_Data == nullptr)
+			fail("MapViewOfFile failed with error " + std::to_string(GetLastError()));
+		m_Size = (size_t)size.QuadPart;
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			fail(std::strerror(errno));
+
+		struct stat status {};
+		if (::fstat(fd, &status) < 0) {
+			int error = errno;
+			::close(fd);
+			fail(std::strerror(error));
+		}
+
+		// an empty file cannot be mapped; it is viewed as an empty string
+		if (status.st_size == 0) {
+			::close(fd);
+			return;
+		}
+
+		void* address = ::mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		int error = errno;
+		// the mapping keeps its own reference to the file
+		::close(fd);
+
+		if (address == MAP_FAILED)
+			fail(std::strerror(error));
+
+		m_Data = (const char*)address;
+		m_Size = (size_t)status.st_size;
+
+		// the hint is only advice, so a failure is not an error
+		int advice = access == MF_ACCESS::MA_SEQUENTIAL ? MADV_SEQUENTIAL : access == MF_ACCESS::MA_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+		::madvise(address, m_Size, advice);
+#endif
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		_unmap();
+
+		m_Data = std::exchange(other.m_Data, nullptr);
+		m_Size = std::exchange(other.m_Size, 0);
+#if defined(_WIN32)
+		m_File = std::exchange(other.m_File, nullptr);
+		m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+
+		return *this;
+	}
+
+	void MappedFile::_unmap()
+	{
+#if defined(_WIN32)
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle((HANDLE)m_Mapping);
+		if (m_File)
+			CloseHandle((HANDLE)m_File);
+
+		m_File = m_Mapping = nullptr;
+#else
+		if (m_Data)
+			::munmap((void*)m_Data, m_Size);
+#endif
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+}
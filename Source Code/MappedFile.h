@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Logger.h"
+#include "DFA.h"
+
+namespace m0st4fa {
+
+	// ENUMS
+	enum class MF_ACCESS {
+		MA_SEQUENTIAL = 0, // read-ahead aggressively and drop pages behind the reader
+		MA_RANDOM,
+		MA_NORMAL,
+		MA_ACCESS_MAX,
+	};
+
+	// DECLARATIONS
+	/**
+	* @brief A read-only memory mapping of a whole file.
+	* The contents are viewed in place through view(), so a file can be matched without reading it into a string first.
+	* The access pattern is passed to the OS as a read-ahead hint (madvise() on POSIX, the file flags on Windows).
+	* The mapping lives as long as the object; it can be moved but not copied.
+	*/
+	class MappedFile {
+		const char* m_Data = nullptr;
+		size_t m_Size = 0;
+
+#if defined(_WIN32)
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+
+		Logger m_Logger;
+
+		void _unmap();
+
+	public:
+		MappedFile() = default;
+		MappedFile(const std::string& path, MF_ACCESS = MF_ACCESS::MA_SEQUENTIAL);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) noexcept;
+		MappedFile& operator=(MappedFile&&) noexcept;
+		~MappedFile() { _unmap(); };
+
+		std::string_view view() const { return std::string_view{ m_Data, m_Size }; };
+		const char* data() const { return m_Data; };
+		size_t size() const { return m_Size; };
+		bool empty() const { return m_Size == 0; };
+	};
+
+
+	/**
+	* @brief Simulate the contents of the file at `path` using the given simulation method, without copying the file.
+	* The match is reported as file offsets; the result does not view the input since the mapping is released on return.
+	*/
+	template <typename TransFuncT, typename InputT>
+	FSMResult simulateFile(const DeterFiniteAutomatan<TransFuncT, InputT>& automaton, const std::string& path, FSM_MODE mode) {
+		MappedFile file{ path, MF_ACCESS::MA_SEQUENTIAL };
+
+		FSMResult res = automaton.simulate(file.view(), mode);
+		res.input = {};
+
+		return res;
+	}
+
+	/**
+	* @brief Return the non-overlapping leftmost-longest matches in the file at `path` as file offsets, without copying the file.
+	*/
+	template <typename TransFuncT, typename InputT>
+	std::vector<FSMResult> findAllInFile(const DeterFiniteAutomatan<TransFuncT, InputT>& automaton, const std::string& path) {
+		MappedFile file{ path, MF_ACCESS::MA_SEQUENTIAL };
+
+		std::vector<FSMResult> matches = automaton.findAll(file.view());
+		for (FSMResult& match : matches)
+			match.input = {};
+
+		return matches;
+	}
+
+}
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "FiniteStateMachine.h"
-#include <stack>
+#include "SparseSet.h"
+#include "NFABitParallel.h"
+#include "NFABitset.h"
 #include <functional>
+#include <algorithm>
+#include <variant>
 
 namespace m0st4fa {
 
@@ -13,18 +17,66 @@ namespace m0st4fa {
 	*/
 	template <typename TransFuncT, typename InputT = std::string>
 	class NonDeterFiniteAutomatan : FiniteStateMachine<TransFuncT, InputT> {
+		// fields
+		/**
+		* One flag per state telling whether the state is final.
+		* Acceptance tests index it instead of hashing into the set of final states.
+		*/
+		std::vector<bool> m_IsFinal;
+
+		/**
+		* The epsilon closure of every state of an epsilon NFA, computed once on construction; empty for other machines.
+		* The closure of `s` is the sorted run `m_ClosureStates[m_ClosureOffsets[s] .. m_ClosureOffsets[s + 1])` and includes `s` itself.
+		*/
+		std::vector<size_t> m_ClosureOffsets;
+		std::vector<state_t> m_ClosureStates;
+
+		/**
+		* Machines of at most BitParallelNFA<4>::MAX_STATES states are simulated by the bit-parallel engine with the fewest words that holds them,
+		* and machines of at most BitsetNFA::MAX_STATES by the bitset engine if its rows fit in BitsetNFA::MAX_ROW_BYTES;
+		* other machines keep the monostate and are simulated over SparseSets.
+		*/
+		std::variant<std::monostate, BitParallelNFA<1>, BitParallelNFA<2>, BitParallelNFA<4>, BitsetNFA> m_BitParallel;
+
 		// static variables
 		constexpr static state_t DEAD_STATE = 0;
 
+		// what a simulation over SparseSets found: whether it accepted, the span it matched and the final states it ended in
+		struct Match {
+			bool accepted = false;
+			size_t start = 0;
+			size_t end = 0;
+			SparseSet finals;
+		};
+
 		// private methods
-		FSMResult _simulate_whole_string(const InputT&) const;
-		FSMResult _simulate_longest_prefix(const InputT&) const;
-		FSMResult _simulate_longest_substring(const InputT&) const;
+		bool _is_final(state_t state) const { return state < m_IsFinal.size() && m_IsFinal[state]; };
+		Match _simulate(std::string_view, FSM_MODE) const;
+		Match _simulate_whole_string(std::string_view) const;
+		Match _simulate_longest_prefix(std::string_view) const;
+		Match _simulate_longest_substring(std::string_view) const;
+
+		/**
+		* The simulation keeps its sets of states in SparseSets sized to the number of states, allocated once per call.
+		* `_step` fills `next` with the states `curr` moves to on `c` and their closures, reading the table's entries in place rather than building their union.
+		* `_add_closure` adds a state and its precomputed closure to a set.
+		*/
+		void _step(const SparseSet& curr, char c, SparseSet& next) const;
+		void _add_closure(SparseSet&, state_t) const;
+		void _compute_epsilon_closures(size_t stateCount);
+		void _build_bit_parallel();
 
-		bool _check_accepted_longest_prefix(const std::vector<state_set_t>&, size_t&) const;
-		bool _check_accepted_substring(const InputT&, std::vector<state_set_t>&, size_t, size_t&) const;
-		state_set_t _epsilon_closure(const state_set_t&) const;
-		state_set_t _get_final_states(const state_set_t&) const;
+		// the states `state` moves to on `c`; states and bytes past the table move nowhere, as in the DFA
+		const state_set_t& _targets(state_t state, unsigned char c) const {
+			static const state_set_t NO_STATES;
+
+			if (state >= this->m_TransitionFunc.m_StateMax || c >= this->m_TransitionFunc.m_InputMax)
+				return NO_STATES;
+
+			return this->m_TransitionFunc.entry(state, c);
+		};
+		bool _has_final(const SparseSet&) const;
+		void _get_final_states(const SparseSet&, SparseSet& finals) const;
 
 	public:
 		NonDeterFiniteAutomatan() = default;
@@ -45,10 +97,59 @@ namespace m0st4fa {
 				throw std::invalid_argument(message);
 			};
 
+			// index the final states
+			size_t stateCount = this->m_TransitionFunc.m_StateMax;
+			for (state_t s : fStates)
+				stateCount = std::max<size_t>(stateCount, s + 1);
+
+			m_IsFinal.assign(stateCount, false);
+			for (state_t s : fStates)
+				m_IsFinal[s] = true;
+
+			// the sets of states used by the simulation hold states below `stateCount` and do not check them
+			const auto& transFn = this->m_TransitionFunc;
+			for (size_t s = 0; s < transFn.m_StateMax; s++)
+				for (size_t input = 0; input < transFn.m_InputMax; input++)
+					for (state_t target : transFn.entry(s, input))
+						if (target >= stateCount) {
+							const std::string message = "NonDeterFiniteAutomatan: the transition function moves to state " + std::to_string(target) + " which has no row in the table.";
+							this->m_Logger.log(loggerInfo, message);
+							throw std::invalid_argument(message);
+						}
+
+			if (machineType == FSM_TYPE::MT_EPSILON_NFA)
+				this->_compute_epsilon_closures(stateCount);
+
+			this->_build_bit_parallel();
+
 		};
 
 
-		FSMResult simulate(const InputT&, FSM_MODE) const;
+		FSMResult simulate(std::string_view, FSM_MODE) const;
+		FSMResult simulate(std::span<const std::byte> input, FSM_MODE mode) const {
+			return this->simulate(toStringView(input), mode);
+		};
+		FSMStateSetResult simulateStateSet(std::string_view, FSM_MODE) const;
+
+		// whether the machine is simulated by a BitParallelNFA or a BitsetNFA
+		bool isBitParallel() const { return m_BitParallel.index() != 0; };
+
+		using FiniteStateMachine<TransFuncT, InputT>::getFinalStates;
+		using FiniteStateMachine<TransFuncT, InputT>::getFlags;
+		using FiniteStateMachine<TransFuncT, InputT>::getMachineType;
+		const TransFuncT& getTransitionFunction() const { return this->m_TransitionFunc; };
+		// the number of states, counting final states past the end of the table
+		size_t getStateCount() const { return m_IsFinal.size(); };
+		/**
+		* The sorted epsilon closure of `state`, which holds `state` itself.
+		* Only an epsilon NFA keeps closures; for other machines the closure is empty.
+		*/
+		std::span<const state_t> getEpsilonClosure(state_t state) const {
+			if (m_ClosureOffsets.empty())
+				return {};
+
+			return std::span<const state_t>{ m_ClosureStates.data() + m_ClosureOffsets.at(state), m_ClosureStates.data() + m_ClosureOffsets.at(state + 1) };
+		};
 
 	};
 
@@ -57,273 +158,280 @@ namespace m0st4fa {
 
 	// IMPLEMENTATIONS
 	template<typename TransFuncT, typename InputT>
-	FSMResult NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate_whole_string(const InputT& input) const
+	typename NonDeterFiniteAutomatan<TransFuncT, InputT>::Match NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate_whole_string(std::string_view input) const
 	{
 		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		state_set_t currState = { startState };
+		SparseSet currState(m_IsFinal.size()), nextState(m_IsFinal.size());
+		this->_add_closure(currState, startState);
 
 		/**
 		 * Follow a path through the machine using the characters of the string.
-		 * Break if you hit a dead state since it is dead.
+		 * Break if the set of states is empty since nothing can leave it.
 		*/
-		if (this->getMachineType() == FSM_TYPE::MT_NON_EPSILON_NFA) // If the machine is a non-epsilon NFA
-			for (auto c : input)
-				currState = this->m_TransitionFunc(currState, c);
-		else // If the machine is an epsilon NFA
-			for (auto c : input)
-				currState = _epsilon_closure(this->m_TransitionFunc(currState, c));
-		
-		bool accepted = false;
-		const state_set_t& finalStates = this->getFinalStates();
-
-		// assert whether we've reached a final state
-		state_set_t finalState;
-		auto lambda = [&finalState, &finalStates](state_t s) {
-			if (finalStates.contains(s))
-				finalState.insert(s);
-		};
+		for (auto c : input) {
+			this->_step(currState, c, nextState);
+			std::swap(currState, nextState);
 
-
-		if (accepted)
-			std::for_each(currState.begin(), currState.end(), lambda);
-		else
-			finalState = state_set_t{ startState };
+			if (currState.empty())
+				break;
+		}
 		
+		// assert whether we've reached a final state
+		if (-not this->_has_final(currState))
+			return Match{};
 
-		return FSMResult(accepted, finalState, { 0, accepted ? input.size() : 0 }, input);
+		this->_get_final_states(currState, nextState);
+		return Match{ true, 0, input.size(), std::move(nextState) };
 	}
 
 	template<typename TransFuncT, typename InputT>
-	FSMResult NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_prefix(const InputT& input) const
+	typename NonDeterFiniteAutomatan<TransFuncT, InputT>::Match NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_prefix(std::string_view input) const
 	{
 		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		std::vector<state_set_t> matchedStatesSet = { {startState} };
+		SparseSet currState(m_IsFinal.size()), nextState(m_IsFinal.size());
+		this->_add_closure(currState, startState);
 
 		/**
-		* keeps track of the path taken through the machine.
-		* Will be used to figure out the longest matched prefix, if any.
+		* Follow a path through the machine using the characters of the string.
+		* Rather than keeping the whole path, remember the last set along it that holds a final state (the end of the longest accepted prefix) and its final states.
 		*/
+		Match match{ false, 0, 0, SparseSet(m_IsFinal.size()) };
 
-		/**
-		 * Follow a path through the machine using the characters of the string.
-		 * Keep track of that path in order to be able to find the longest prefix if the whole string is not accepted.
-		*/
-		if (this->getMachineType() == FSM_TYPE::MT_NON_EPSILON_NFA)
-			for (auto c : input)
-				// get next set of states and update our path through the machine
-				matchedStatesSet.push_back(this->m_TransitionFunc(matchedStatesSet.back(), c));
-		else 
-			for (auto c : input)
-				// get next set of states and update our path through the machine
-				matchedStatesSet.push_back(this->_epsilon_closure(this->m_TransitionFunc(matchedStatesSet.back(), c)));
-
-		// set the index
-		size_t index = matchedStatesSet.size();
-
-		// figure out whether there is an accepted longest prefix
-		bool accepted = _check_accepted_longest_prefix(matchedStatesSet, index);
-		
-		const state_set_t& finalStates = this->getFinalStates();
+		auto record = [&](size_t charCount) {
+			if (-not this->_has_final(currState))
+				return;
 
-		// assert whether we've reached a final state
-		state_set_t finalState;
-		auto lambda = [&finalState, &finalStates](state_t s) {
-			if (finalStates.contains(s))
-				finalState.insert(s);
+			match.accepted = true;
+			match.end = charCount;
+			this->_get_final_states(currState, match.finals);
 		};
 
-		auto currState = matchedStatesSet.at(index);
-		if (accepted)
-			std::for_each(currState.begin(), currState.end(), lambda);
-		else
-			finalState = state_set_t{ startState };
+		record(0);
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+			// get next set of states and update our path through the machine
+			this->_step(currState, input[charIndex], nextState);
+			std::swap(currState, nextState);
+
+			if (currState.empty())
+				break;
+
+			record(charIndex + 1);
+		}
 
-		return FSMResult(accepted, finalState, { 0, index }, input);
+		return match;
 	}
 
 	template<typename TransFuncT, typename InputT>
-	FSMResult NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_substring(const InputT& input) const
+	typename NonDeterFiniteAutomatan<TransFuncT, InputT>::Match NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate_longest_substring(std::string_view input) const
 	{
 		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		std::vector<state_set_t> matchedStatesSet = { {startState} };
+		constexpr size_t NO_MATCH = (size_t)-1;
+
 		/**
-		* keeps track of the path taken through the machine.
-		* Will be used to figure out the longest matched prefix, if any.
+		* All the match attempts are run together in a single forward pass, as if the machine had an implicit `.*?` loop before its start state.
+		* An attempt is a state paired with the index at which the attempt started; the list is kept ordered by start index.
+		* When several attempts reach the same state, only the one that started first (the leftmost) is kept.
+		* This bounds the number of live attempts by the number of states and makes the scan linear in the length of the input.
 		*/
-		size_t startIndex = 0, charIndex = 0;
-		size_t endIndex = 0;
+		struct Attempt {
+			state_t state;
+			size_t start;
+		};
+
+		const size_t stateCount = m_IsFinal.size();
+		std::vector<Attempt> currAttempts, nextAttempts;
+		currAttempts.reserve(stateCount);
+		nextAttempts.reserve(stateCount);
+		// the generation in which each state was last claimed by an attempt
+		std::vector<size_t> claimed(stateCount, 0);
+		size_t generation = 1;
+
+		size_t matchStart = NO_MATCH, matchEnd = 0;
+		SparseSet matchStates(stateCount);
+
+		// the states reached by a single attempt, closed over epsilon transitions
+		SparseSet reached(stateCount);
+
+		// claim the states in `reached` for an attempt that started at `start`
+		auto claim = [&](size_t start) {
+			for (state_t s : reached) {
+				if (claimed[s] == generation)
+					continue;
+
+				claimed[s] = generation;
+				nextAttempts.push_back({ s, start });
+			}
+		};
+
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+
+			// start a new attempt at this index, unless a match is already found (a later attempt cannot be leftmost)
+			if (matchStart == NO_MATCH) {
+				nextAttempts.clear();
+				reached.clear();
+				this->_add_closure(reached, startState);
+				claim(charIndex);
+				currAttempts.insert(currAttempts.end(), nextAttempts.begin(), nextAttempts.end());
+			}
+
+			generation++;
+			nextAttempts.clear();
+			const auto c = input[charIndex];
+
+			for (const Attempt& attempt : currAttempts) {
+				// attempts that started after the current match cannot replace it
+				if (attempt.start > matchStart && matchStart != NO_MATCH)
+					break;
+
+				reached.clear();
+				for (state_t s : this->_targets(attempt.state, c))
+					this->_add_closure(reached, s);
 
-		for (; charIndex < input.size(); charIndex = ++startIndex ) {
+				claim(attempt.start);
+			}
+
+			// prefer the leftmost start, then the longest end
+			for (const Attempt& attempt : nextAttempts) {
+				if (-not this->_is_final(attempt.state))
+					continue;
+
+				if (matchStart == NO_MATCH || attempt.start < matchStart || (attempt.start == matchStart && matchEnd != charIndex + 1)) {
+					matchStart = attempt.start;
+					matchEnd = charIndex + 1;
+					matchStates.clear();
+				}
 
-			// check whether the substring is accepted
-			bool accepted = _check_accepted_substring(input, matchedStatesSet, startIndex, endIndex);
+				if (attempt.start == matchStart)
+					matchStates.insert(attempt.state);
+			}
 
-			// if this substring was not accepted, check the next
-			if (-not accepted)
-				continue;
-			
-			// get the final states we've reached
-			auto& currState = matchedStatesSet.at(endIndex - 1 - startIndex);
-		 	state_set_t finalStateSet = _get_final_states(currState);
-			assert("This set must contain at least a single final state" && finalStateSet.size());
+			std::swap(currAttempts, nextAttempts);
 
-			return FSMResult(true, finalStateSet, { startIndex, endIndex }, input);
+			// no attempt can extend or replace the match
+			if (currAttempts.empty() && matchStart != NO_MATCH)
+				break;
 		}
 
 		// if there was no accepted substring
-		return FSMResult(false, {startState}, {0, 0}, input);
+		if (matchStart == NO_MATCH)
+			return Match{};
+
+		return Match{ true, matchStart, matchEnd, std::move(matchStates) };
 
 	}
 
 	template<typename TransFuncT, typename InputT>
-	bool NonDeterFiniteAutomatan<TransFuncT, InputT>::_check_accepted_longest_prefix(const std::vector<state_set_t>& stateSet, size_t& index) const
+	void NonDeterFiniteAutomatan<TransFuncT, InputT>::_step(const SparseSet& curr, char c, SparseSet& next) const
 	{
-		bool res = false;
-		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
-		/**
-		* Loop through the path from the end seeking the closes final state.
-		* Update the end index as you do so.
-		*/
-		auto it = stateSet.rbegin();
-		while (it != stateSet.rend())
-		{
-			state_set_t currStateSet = *it;
-			
-			//// print the currently searched index (previous index)
-			//this->m_Logger.logDebug(
-			//	"_check_accepted_longest_prefix: current searched index (previous index): " 
-			//	+ 
-			//	std::to_string(index));
-
-			// update the index and the iterators
-			index--;
-			it++;
-
-			// perform the search
-			for (auto s : currStateSet)
-				if (this->getFinalStates().contains(s))
-				{
-					res = true;
-					break;
-				}
-
-			// if a final state is found, break out of the loop
-			if (res)
-				break;
+		next.clear();
 
-		}
-		
-		return res;
+		for (state_t s : curr)
+			for (state_t target : this->_targets(s, c))
+				this->_add_closure(next, target);
 	}
 
 	template<typename TransFuncT, typename InputT>
-	bool NonDeterFiniteAutomatan<TransFuncT, InputT>::_check_accepted_substring(const InputT& input, std::vector<state_set_t>& matchedStatesSet, size_t startIndex, size_t& endIndex) const	
+	void NonDeterFiniteAutomatan<TransFuncT, InputT>::_build_bit_parallel()
 	{
+		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+		const size_t stateCount = m_IsFinal.size();
 
-		/**
-			* Follow a path through the machine using the characters of the string.
-			* Keep track of that path in order to be able to find the longest prefix if the whole string is not accepted.
-		*/
-		size_t charIndex = startIndex;
-		if (this->getMachineType() == FSM_TYPE::MT_NON_EPSILON_NFA)
-			for (; charIndex < input.size(); charIndex++)
-			{
-				auto c = input[charIndex];
-				state_set_t currStateSet = this->m_TransitionFunc(matchedStatesSet.back(), c);
-
-				// if the current state is empty
-				if (-not currStateSet.size())
-					break;
+		if (stateCount > BitsetNFA::MAX_STATES || startState >= stateCount)
+			return;
 
-				// get next set of states
-				// update our path through the machine
-				matchedStatesSet.push_back(currStateSet);
-			}
-		else
-			for (; charIndex < input.size(); charIndex++)
-			{
-				auto c = input[charIndex];
-				auto currStateSet = _epsilon_closure(
-					this->m_TransitionFunc(matchedStatesSet.back(), c)
-				);
-
-				// if the current state is empty
-				if (-not currStateSet.size())
-					break;
+		SparseSet start(stateCount);
+		this->_add_closure(start, startState);
 
-				// get next set of states
-				// update our path through the machine
-				matchedStatesSet.push_back(currStateSet);
-			}
+		auto step = [this](state_t state, unsigned char c, SparseSet& targets) {
+			targets.clear();
 
-		endIndex = matchedStatesSet.size() + startIndex;
-		// figure out whether there is an accepted longest prefix
-		bool accepted = _check_accepted_longest_prefix(matchedStatesSet, endIndex);
+			for (state_t target : this->_targets(state, c))
+				this->_add_closure(targets, target);
+		};
 
-		return accepted;
+		if (stateCount <= BitParallelNFA<1>::MAX_STATES)
+			m_BitParallel.template emplace<BitParallelNFA<1>>(stateCount, startState, start, m_IsFinal, step);
+		else if (stateCount <= BitParallelNFA<2>::MAX_STATES)
+			m_BitParallel.template emplace<BitParallelNFA<2>>(stateCount, startState, start, m_IsFinal, step);
+		else if (stateCount <= BitParallelNFA<4>::MAX_STATES)
+			m_BitParallel.template emplace<BitParallelNFA<4>>(stateCount, startState, start, m_IsFinal, step);
+		else if (auto engine = BitsetNFA::build(stateCount, startState, start, m_IsFinal, step))
+			m_BitParallel = std::move(*engine);
 	}
 
 	template<typename TransFuncT, typename InputT>
-	state_set_t NonDeterFiniteAutomatan<TransFuncT, InputT>::_epsilon_closure(const state_set_t& set) const
+	inline void NonDeterFiniteAutomatan<TransFuncT, InputT>::_add_closure(SparseSet& set, state_t state) const
 	{
-		state_set_t res{set};
-
-		std::stack<state_t> stack{};
-		// initialize the stack
-		for (auto s : set)
-			stack.push(s);
-		
-
-		while (stack.size()) {
-			state_t s = stack.top();
-			stack.pop();
-
-			// check if the state has
-			state_set_t epsilonTransitions = this->m_TransitionFunc(s, '\0');
-
-			if (epsilonTransitions.size() > 0) {
-				/**
-				* Push all the states in the epsilon transitions onto the stack.
-				* We do this to consider whether the state itself has any epsilon transitions.
-				* This applies the recursivness of the algorithm.
-				* Before we push a state, we check to see if it is already in the set so that we don't consider the state again.
-				* If we don't do that, we might end up with an infinite loop.
-				*/ 
-				for (auto state : epsilonTransitions)
-					if (!res.contains(state))
-						stack.push(state);
-
-				res.insert(epsilonTransitions.begin(), epsilonTransitions.end());
-			};
-
-			
-		};
-		
+		/**
+		* Every state of the set came in with its whole closure, which holds the closure of each of its states,
+		* so a state that is already a member needs nothing more.
+		*/
+		if (-not set.insert(state) || m_ClosureOffsets.empty())
+			return;
 
-		return res;
+		for (size_t i = m_ClosureOffsets[state], end = m_ClosureOffsets[state + 1]; i < end; i++)
+			set.insert(m_ClosureStates[i]);
 	}
 
 	template<typename TransFuncT, typename InputT>
-	inline state_set_t NonDeterFiniteAutomatan<TransFuncT, InputT>::_get_final_states(const state_set_t& currStateSet) const
+	void NonDeterFiniteAutomatan<TransFuncT, InputT>::_compute_epsilon_closures(size_t stateCount)
 	{
-		constexpr state_t startState = FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+		const auto& transFn = this->m_TransitionFunc;
+		SparseSet closure(stateCount);
+		std::vector<state_t> stack;
+		stack.reserve(stateCount);
+
+		m_ClosureOffsets.assign(1, 0);
+		m_ClosureStates.clear();
+
+		for (state_t state = 0; state < stateCount; state++) {
+			closure.clear();
+			closure.insert(state);
+			stack.push_back(state);
+
+			/**
+			* Each state is pushed once, when it joins the closure, so that its own epsilon transitions are followed too.
+			* Checking membership before pushing keeps cycles of epsilon transitions from looping forever.
+			*/
+			while (stack.size()) {
+				state_t s = stack.back();
+				stack.pop_back();
+
+				// states past the table have no transitions
+				if (s >= transFn.m_StateMax)
+					continue;
+
+				for (state_t next : transFn.entry(s, '\0'))
+					if (closure.insert(next))
+						stack.push_back(next);
+			}
 
-		const state_set_t& finalStates = this->getFinalStates();
-		state_set_t finalStateSet;
+			const size_t begin = m_ClosureStates.size();
+			m_ClosureStates.insert(m_ClosureStates.end(), closure.begin(), closure.end());
+			std::sort(m_ClosureStates.begin() + begin, m_ClosureStates.end());
+			m_ClosureOffsets.push_back(m_ClosureStates.size());
+		}
+	}
 
-		auto lambda = [&finalStateSet, &finalStates](state_t s) {
-			if (finalStates.contains(s))
-				finalStateSet.insert(s);
-		};
+	template<typename TransFuncT, typename InputT>
+	inline bool NonDeterFiniteAutomatan<TransFuncT, InputT>::_has_final(const SparseSet& currStateSet) const
+	{
+		return std::any_of(currStateSet.begin(), currStateSet.end(), [this](state_t s) { return this->_is_final(s); });
+	}
 
-		std::for_each(currStateSet.begin(), currStateSet.end(), lambda);
+	template<typename TransFuncT, typename InputT>
+	inline void NonDeterFiniteAutomatan<TransFuncT, InputT>::_get_final_states(const SparseSet& currStateSet, SparseSet& finals) const
+	{
+		finals.clear();
 
-		return finalStateSet;
+		for (state_t s : currStateSet)
+			if (this->_is_final(s))
+				finals.insert(s);
 	}
 
 	
 	template<typename TransFuncT, typename InputT>
-	inline FSMResult NonDeterFiniteAutomatan<TransFuncT, InputT>::simulate(const InputT& input, FSM_MODE mode) const
+	typename NonDeterFiniteAutomatan<TransFuncT, InputT>::Match NonDeterFiniteAutomatan<TransFuncT, InputT>::_simulate(std::string_view input, FSM_MODE mode) const
 	{
 		switch (mode) {
 		case FSM_MODE::MM_WHOLE_STRING:
@@ -342,5 +450,52 @@ namespace m0st4fa {
 		}
 
 	}
+
+	/**
+	* @brief Simulate the given input string and report the smallest final state the match ended in.
+	* Every engine finds that state directly, so no set of final states is built.
+	*/
+	template<typename TransFuncT, typename InputT>
+	inline FSMResult NonDeterFiniteAutomatan<TransFuncT, InputT>::simulate(std::string_view input, FSM_MODE mode) const
+	{
+		if (mode >= FSM_MODE::MM_WHOLE_STRING && mode < FSM_MODE::MM_FSM_MODE_MAX) {
+			if (const auto* engine = std::get_if<BitParallelNFA<1>>(&m_BitParallel))
+				return engine->simulate(input, mode);
+			if (const auto* engine = std::get_if<BitParallelNFA<2>>(&m_BitParallel))
+				return engine->simulate(input, mode);
+			if (const auto* engine = std::get_if<BitParallelNFA<4>>(&m_BitParallel))
+				return engine->simulate(input, mode);
+			if (const auto* engine = std::get_if<BitsetNFA>(&m_BitParallel))
+				return engine->simulate(input, mode);
+		}
+
+		const Match match = this->_simulate(input, mode);
+		const state_t finalState = match.accepted ? *std::min_element(match.finals.begin(), match.finals.end()) : FiniteStateMachine<TransFuncT, InputT>::START_STATE;
+
+		return FSMResult(match.accepted, finalState, { match.start, match.end }, input);
+	}
+
+	/**
+	* @brief Simulate the given input string and report every final state the match ended in.
+	*/
+	template<typename TransFuncT, typename InputT>
+	inline FSMStateSetResult NonDeterFiniteAutomatan<TransFuncT, InputT>::simulateStateSet(std::string_view input, FSM_MODE mode) const
+	{
+		if (mode >= FSM_MODE::MM_WHOLE_STRING && mode < FSM_MODE::MM_FSM_MODE_MAX) {
+			if (const auto* engine = std::get_if<BitParallelNFA<1>>(&m_BitParallel))
+				return engine->simulateStateSet(input, mode);
+			if (const auto* engine = std::get_if<BitParallelNFA<2>>(&m_BitParallel))
+				return engine->simulateStateSet(input, mode);
+			if (const auto* engine = std::get_if<BitParallelNFA<4>>(&m_BitParallel))
+				return engine->simulateStateSet(input, mode);
+			if (const auto* engine = std::get_if<BitsetNFA>(&m_BitParallel))
+				return engine->simulateStateSet(input, mode);
+		}
+
+		const Match match = this->_simulate(input, mode);
+		state_set_t finalStates = match.accepted ? state_set_t(match.finals.begin(), match.finals.end()) : state_set_t{ FiniteStateMachine<TransFuncT, InputT>::START_STATE };
+
+		return FSMStateSetResult(match.accepted, finalStates, { match.start, match.end }, input);
+	}
 	
 }
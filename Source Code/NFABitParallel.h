@@ -0,0 +1,425 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "FiniteStateMachine.h"
+#include "SparseSet.h"
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	/**
+	* @brief Simulates an NFA of at most 64 * Words states with its sets of states packed into Words machine words, one bit per state.
+	* The bytes are grouped into classes on which every state moves to the same states, and every state keeps one mask per class
+	* of the states it moves to, epsilon closures included; a step ORs the masks of the states in the set.
+	*
+	* When every transition goes from a state to the next one (the position automaton of a pattern without loops or alternatives, numbered in order),
+	* a step is the Shift-And update `(D << 1) & entered[class]`: a shift and an AND per word, however many states are active.
+	* Otherwise, when the machine has a single word and is in Glushkov form (every state is entered on the same bytes from wherever it is entered),
+	* a step is `follow(D) & entered[class]`, where follow(D) is the OR of one precomputed mask per byte of D:
+	* eight lookups, an AND and a few ORs per character.
+	*
+	* The sets tracked are the ones NonDeterFiniteAutomatan tracks, so simulate() and simulateStateSet() report the same results in every FSM_MODE.
+	*/
+	template <size_t Words>
+	class BitParallelNFA {
+	public:
+		using Mask = std::array<std::uint64_t, Words>;
+		constexpr static size_t MAX_STATES = 64 * Words;
+
+	private:
+		constexpr static size_t CHUNK_COUNT = sizeof(std::uint64_t);
+
+		size_t m_StateCount = 0;
+		state_t m_StartState = 0;
+		Mask m_Start{};
+		Mask m_Final{};
+
+		ByteClassMap m_ByteClasses{};
+		size_t m_ClassCount = 0;
+		// the mask of every state on every class, the states of a class being contiguous: `m_Masks[cls * m_StateCount + s]`
+		std::vector<Mask> m_Masks;
+
+		// Shift-And and Glushkov forms: `m_Entered[cls]` is the states entered on `cls`
+		bool m_Shift = false;
+		std::vector<Mask> m_Entered;
+		// Glushkov form only: `m_Follow[chunk * BYTE_COUNT + value]` is what the states of byte `chunk` of a set move to
+		bool m_Glushkov = false;
+		std::vector<Mask> m_Follow;
+
+		static bool _any(const Mask& mask) {
+			for (std::uint64_t word : mask)
+				if (word)
+					return true;
+
+			return false;
+		};
+
+		// what a simulation found: whether it accepted, the span it matched and the final states it ended in
+		struct Match {
+			bool accepted = false;
+			size_t start = 0;
+			size_t end = 0;
+			Mask finals{};
+		};
+
+		Mask _step(const Mask&, unsigned char) const;
+		state_set_t _get_states(const Mask&) const;
+		static state_t _min_state(const Mask&);
+
+		Match _simulate(std::string_view, FSM_MODE) const;
+		Match _simulate_whole_string(std::string_view) const;
+		Match _simulate_longest_prefix(std::string_view) const;
+		Match _simulate_longest_substring(std::string_view) const;
+
+	public:
+		BitParallelNFA() = default;
+		/**
+		* @param start the closure of the start state.
+		* @param step `step(state, byte, out)` fills `out` with the states `state` moves to on `byte`, closures included.
+		*/
+		template <typename StepFn>
+		BitParallelNFA(size_t stateCount, state_t startState, const SparseSet& start, const std::vector<bool>& isFinal, StepFn step);
+
+		// report the smallest final state the match ended in
+		FSMResult simulate(std::string_view, FSM_MODE) const;
+		// report every final state the match ended in
+		FSMStateSetResult simulateStateSet(std::string_view, FSM_MODE) const;
+
+		bool isShiftAnd() const { return m_Shift; };
+		bool isGlushkov() const { return m_Glushkov; };
+		size_t getClassCount() const { return m_ClassCount; };
+	};
+
+
+	// IMPLEMENTATIONS
+	template <size_t Words>
+	template <typename StepFn>
+	BitParallelNFA<Words>::BitParallelNFA(size_t stateCount, state_t startState, const SparseSet& start, const std::vector<bool>& isFinal, StepFn step) :
+		m_StateCount{ stateCount }, m_StartState{ startState }
+	{
+		auto set = [](Mask& mask, state_t s) { mask[s / 64] |= std::uint64_t(1) << (s % 64); };
+
+		for (state_t s : start)
+			set(m_Start, s);
+
+		for (state_t s = 0; s < stateCount; s++)
+			if (isFinal[s])
+				set(m_Final, s);
+
+		// the column of every byte, grouping equal columns into classes
+		SparseSet targets(stateCount);
+		std::vector<Mask> column(stateCount);
+
+		for (size_t b = 0; b < BYTE_COUNT; b++) {
+			for (state_t s = 0; s < stateCount; s++) {
+				step(s, (unsigned char)b, targets);
+				column[s] = Mask{};
+				for (state_t t : targets)
+					set(column[s], t);
+			}
+
+			size_t cls = 0;
+			while (cls < m_ClassCount && -not std::equal(column.begin(), column.end(), m_Masks.begin() + cls * stateCount))
+				cls++;
+
+			if (cls == m_ClassCount) {
+				m_Masks.insert(m_Masks.end(), column.begin(), column.end());
+				m_ClassCount++;
+			}
+
+			m_ByteClasses[b] = (byte_class_t)cls;
+		}
+
+		m_Entered.assign(m_ClassCount, Mask{});
+		for (size_t cls = 0; cls < m_ClassCount; cls++)
+			for (state_t s = 0; s < stateCount; s++)
+				for (size_t w = 0; w < Words; w++)
+					m_Entered[cls][w] |= m_Masks[cls * stateCount + s][w];
+
+		// the machine is in Shift-And form if every state moves nowhere or to the next state only, so that a state is entered from the one before it
+		m_Shift = true;
+		for (size_t i = 0; i < m_Masks.size() && m_Shift; i++) {
+			const state_t s = (state_t)(i % stateCount);
+			Mask next{};
+			if (s + 1 < MAX_STATES)
+				set(next, s + 1);
+
+			m_Shift = -not _any(m_Masks[i]) || m_Masks[i] == next;
+		}
+
+		// the follow table covers a single word
+		if (Words == 1 && -not m_Shift) {
+			// follow(s) is every state `s` moves to; the machine is in Glushkov form if restricting it to the states entered on a class gives the mask of that class
+			std::vector<Mask> follow(stateCount);
+
+			for (size_t cls = 0; cls < m_ClassCount; cls++)
+				for (state_t s = 0; s < stateCount; s++)
+					follow[s][0] |= m_Masks[cls * stateCount + s][0];
+
+			m_Glushkov = true;
+			for (size_t cls = 0; cls < m_ClassCount && m_Glushkov; cls++)
+				for (state_t s = 0; s < stateCount && m_Glushkov; s++)
+					m_Glushkov = m_Masks[cls * stateCount + s][0] == (follow[s][0] & m_Entered[cls][0]);
+
+			if (m_Glushkov) {
+				m_Follow.assign(CHUNK_COUNT * BYTE_COUNT, Mask{});
+
+				for (size_t chunk = 0; chunk < CHUNK_COUNT; chunk++)
+					for (size_t value = 1; value < BYTE_COUNT; value++) {
+						// extend the entry of `value` without its lowest bit by the state of that bit
+						const size_t bit = std::countr_zero(value);
+						const state_t s = (state_t)(chunk * 8 + bit);
+						const Mask& rest = m_Follow[chunk * BYTE_COUNT + (value & (value - 1))];
+
+						m_Follow[chunk * BYTE_COUNT + value][0] = rest[0] | (s < stateCount ? follow[s][0] : 0);
+					}
+			}
+		}
+
+		if (-not m_Shift && -not m_Glushkov)
+			m_Entered.clear();
+	}
+
+	template <size_t Words>
+	inline typename BitParallelNFA<Words>::Mask BitParallelNFA<Words>::_step(const Mask& curr, unsigned char c) const
+	{
+		const size_t cls = m_ByteClasses[c];
+		Mask next{};
+
+		// move every state to the next one, carrying the top bit of each word into the word above
+		if (m_Shift) {
+			const Mask& entered = m_Entered[cls];
+			std::uint64_t carry = 0;
+
+			for (size_t w = 0; w < Words; w++) {
+				next[w] = ((curr[w] << 1) | carry) & entered[w];
+				carry = curr[w] >> 63;
+			}
+
+			return next;
+		}
+
+		if constexpr (Words == 1)
+			if (m_Glushkov) {
+				std::uint64_t word = curr[0];
+
+				for (size_t chunk = 0; word; chunk++, word >>= 8)
+					if (word & 0xff)
+						next[0] |= m_Follow[chunk * BYTE_COUNT + (word & 0xff)][0];
+
+				next[0] &= m_Entered[cls][0];
+				return next;
+			}
+
+		// OR the masks of the states in the set, visiting its bits from the lowest
+		const Mask* masks = m_Masks.data() + cls * m_StateCount;
+		for (size_t w = 0; w < Words; w++)
+			for (std::uint64_t word = curr[w]; word; word &= word - 1) {
+				const Mask& mask = masks[w * 64 + std::countr_zero(word)];
+
+				for (size_t i = 0; i < Words; i++)
+					next[i] |= mask[i];
+			}
+
+		return next;
+	}
+
+	template <size_t Words>
+	state_set_t BitParallelNFA<Words>::_get_states(const Mask& mask) const
+	{
+		state_set_t states;
+
+		for (size_t w = 0; w < Words; w++)
+			for (std::uint64_t word = mask[w]; word; word &= word - 1)
+				states.insert((state_t)(w * 64 + std::countr_zero(word)));
+
+		return states;
+	}
+
+	template <size_t Words>
+	inline state_t BitParallelNFA<Words>::_min_state(const Mask& mask)
+	{
+		for (size_t w = 0; w < Words; w++)
+			if (mask[w])
+				return (state_t)(w * 64 + std::countr_zero(mask[w]));
+
+		return 0;
+	}
+
+	template <size_t Words>
+	typename BitParallelNFA<Words>::Match BitParallelNFA<Words>::_simulate_whole_string(std::string_view input) const
+	{
+		Mask curr = m_Start;
+
+		for (auto c : input) {
+			curr = this->_step(curr, (unsigned char)c);
+
+			if (-not _any(curr))
+				break;
+		}
+
+		// the final states reached
+		Mask finals;
+		for (size_t w = 0; w < Words; w++)
+			finals[w] = curr[w] & m_Final[w];
+
+		if (-not _any(finals))
+			return Match{};
+
+		return Match{ true, 0, input.size(), finals };
+	}
+
+	template <size_t Words>
+	typename BitParallelNFA<Words>::Match BitParallelNFA<Words>::_simulate_longest_prefix(std::string_view input) const
+	{
+		Mask curr = m_Start;
+		Match match;
+
+		// remember the final states of the last set that holds any
+		auto record = [&](size_t charCount) {
+			Mask finals;
+			for (size_t w = 0; w < Words; w++)
+				finals[w] = curr[w] & m_Final[w];
+
+			if (-not _any(finals))
+				return;
+
+			match = Match{ true, 0, charCount, finals };
+		};
+
+		record(0);
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+			curr = this->_step(curr, (unsigned char)input[charIndex]);
+
+			if (-not _any(curr))
+				break;
+
+			record(charIndex + 1);
+		}
+
+		return match;
+	}
+
+	template <size_t Words>
+	typename BitParallelNFA<Words>::Match BitParallelNFA<Words>::_simulate_longest_substring(std::string_view input) const
+	{
+		constexpr size_t NO_MATCH = (size_t)-1;
+
+		/**
+		* As in NonDeterFiniteAutomatan, all the match attempts run in one forward pass and a state belongs to the attempt that started first.
+		* The attempts that started at the same index form a group whose states are a mask; the groups are disjoint and ordered by start index,
+		* so there are never more groups than states.
+		*/
+		struct Group {
+			size_t start;
+			Mask states;
+		};
+
+		std::vector<Group> currGroups, nextGroups;
+		currGroups.reserve(m_StateCount + 1);
+		nextGroups.reserve(m_StateCount + 1);
+		// the states of all the current groups
+		Mask claimed{};
+
+		size_t matchStart = NO_MATCH, matchEnd = 0;
+		Mask matchStates{};
+
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+
+			// start a new attempt at this index with the states no earlier attempt holds, unless a match is already found
+			if (matchStart == NO_MATCH) {
+				Mask states;
+				for (size_t w = 0; w < Words; w++)
+					states[w] = m_Start[w] & ~claimed[w];
+
+				if (_any(states))
+					currGroups.push_back({ charIndex, states });
+			}
+
+			nextGroups.clear();
+			claimed = Mask{};
+
+			for (const Group& group : currGroups) {
+				// attempts that started after the current match cannot replace it
+				if (group.start > matchStart && matchStart != NO_MATCH)
+					break;
+
+				Mask states = this->_step(group.states, (unsigned char)input[charIndex]);
+				for (size_t w = 0; w < Words; w++) {
+					states[w] &= ~claimed[w];
+					claimed[w] |= states[w];
+				}
+
+				if (_any(states))
+					nextGroups.push_back({ group.start, states });
+			}
+
+			// prefer the leftmost start, then the longest end; the first group holding a final state has the leftmost start
+			for (const Group& group : nextGroups) {
+				Mask finals;
+				for (size_t w = 0; w < Words; w++)
+					finals[w] = group.states[w] & m_Final[w];
+
+				if (-not _any(finals))
+					continue;
+
+				if (matchStart == NO_MATCH || group.start <= matchStart) {
+					matchStart = group.start;
+					matchEnd = charIndex + 1;
+					matchStates = finals;
+				}
+
+				break;
+			}
+
+			std::swap(currGroups, nextGroups);
+
+			// no attempt can extend or replace the match
+			if (currGroups.empty() && matchStart != NO_MATCH)
+				break;
+		}
+
+		// if there was no accepted substring
+		if (matchStart == NO_MATCH)
+			return Match{};
+
+		return Match{ true, matchStart, matchEnd, matchStates };
+	}
+
+	template <size_t Words>
+	inline typename BitParallelNFA<Words>::Match BitParallelNFA<Words>::_simulate(std::string_view input, FSM_MODE mode) const
+	{
+		switch (mode) {
+		case FSM_MODE::MM_WHOLE_STRING:
+			return this->_simulate_whole_string(input);
+		case FSM_MODE::MM_LONGEST_PREFIX:
+			return this->_simulate_longest_prefix(input);
+		default:
+			return this->_simulate_longest_substring(input);
+		}
+	}
+
+	template <size_t Words>
+	inline FSMResult BitParallelNFA<Words>::simulate(std::string_view input, FSM_MODE mode) const
+	{
+		const Match match = this->_simulate(input, mode);
+		const state_t finalState = match.accepted ? _min_state(match.finals) : m_StartState;
+
+		return FSMResult(match.accepted, finalState, { match.start, match.end }, input);
+	}
+
+	template <size_t Words>
+	inline FSMStateSetResult BitParallelNFA<Words>::simulateStateSet(std::string_view input, FSM_MODE mode) const
+	{
+		const Match match = this->_simulate(input, mode);
+		state_set_t finalStates = match.accepted ? this->_get_states(match.finals) : state_set_t{ m_StartState };
+
+		return FSMStateSetResult(match.accepted, finalStates, { match.start, match.end }, input);
+	}
+
+}
@@ -0,0 +1,434 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "FiniteStateMachine.h"
+#include "SparseSet.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FSM_BITSET_AVX2 1
+#else
+#define FSM_BITSET_AVX2 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FSM_BITSET_SSE2 1
+#else
+#define FSM_BITSET_SSE2 0
+#endif
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	/**
+	* @brief Simulates an NFA too large for BitParallelNFA with its sets of states as bitsets of a width fixed on construction.
+	* As in BitParallelNFA, the bytes are grouped into classes and every state keeps, per class, a bitset row of the states it moves to
+	* (epsilon closures included); a step ORs the rows of the states in the set.
+	* Rows are padded to whole 256-bit blocks and ORed a block at a time with AVX2 where the build enables it (FSM_BITSET_AVX2),
+	* or 128 bits at a time with SSE2 (FSM_BITSET_SSE2), so the cost of a step is the number of active states times the row width,
+	* whatever the shape of the machine.
+	*
+	* The rows take (classes * states^2 / 8) bytes, 128 KB per class at MAX_STATES; build() gives up on machines whose rows would take more than MAX_ROW_BYTES,
+	* which NonDeterFiniteAutomatan then simulates over SparseSets.
+	* The sets tracked are the ones NonDeterFiniteAutomatan tracks, so simulate() and simulateStateSet() report the same results in every FSM_MODE.
+	*/
+	class BitsetNFA {
+	public:
+		constexpr static size_t MAX_STATES = 1024;
+		// the most memory the rows may take: 32 classes at MAX_STATES
+		constexpr static size_t MAX_ROW_BYTES = size_t(4) << 20;
+
+	private:
+		// rows are padded to a multiple of this many words (256 bits)
+		constexpr static size_t BLOCK_WORDS = 4;
+
+		// a set of states wide enough for any machine, so the whole-string and prefix scans keep their sets off the heap
+		using Bits = std::array<std::uint64_t, MAX_STATES / 64>;
+
+		// what a simulation found: whether it accepted, the span it matched and the final states it ended in
+		struct Match {
+			bool accepted = false;
+			size_t start = 0;
+			size_t end = 0;
+			Bits finals{};
+		};
+
+		size_t m_StateCount = 0;
+		size_t m_WordCount = 0;
+		state_t m_StartState = 0;
+		std::vector<std::uint64_t> m_Start;
+		std::vector<std::uint64_t> m_Final;
+
+		ByteClassMap m_ByteClasses{};
+		size_t m_ClassCount = 0;
+		// the row of every state on every class, the rows of a class being contiguous: `m_Rows[(cls * m_StateCount + s) * m_WordCount ...]`
+		std::vector<std::uint64_t> m_Rows;
+
+		bool _any(const std::uint64_t*) const;
+		bool _any_final(const std::uint64_t*) const;
+		void _or(std::uint64_t* dest, const std::uint64_t* row) const;
+		void _step(const std::uint64_t* curr, unsigned char, std::uint64_t* next) const;
+		state_set_t _get_final_states(const std::uint64_t*) const;
+		state_t _min_final_state(const std::uint64_t*) const;
+		Match _match(size_t start, size_t end, const std::uint64_t* states) const;
+
+		Match _simulate(std::string_view, FSM_MODE) const;
+		Match _simulate_whole_string(std::string_view) const;
+		Match _simulate_longest_prefix(std::string_view) const;
+		Match _simulate_longest_substring(std::string_view) const;
+
+		static std::uint64_t _mix(std::uint64_t);
+
+		// builds the rows, or stops with no class at all once they would take more than MAX_ROW_BYTES
+		template <typename StepFn>
+		BitsetNFA(size_t stateCount, state_t startState, const SparseSet& start, const std::vector<bool>& isFinal, StepFn step);
+
+	public:
+		BitsetNFA() = default;
+		/**
+		* @brief Return the engine of the machine, or nothing if its rows would take more than MAX_ROW_BYTES.
+		* @param start the closure of the start state.
+		* @param step `step(state, byte, out)` fills `out` with the states `state` moves to on `byte`, closures included.
+		*/
+		template <typename StepFn>
+		static std::optional<BitsetNFA> build(size_t stateCount, state_t startState, const SparseSet& start, const std::vector<bool>& isFinal, StepFn step) {
+			BitsetNFA engine{ stateCount, startState, start, isFinal, step };
+
+			if (engine.m_ClassCount == 0)
+				return std::nullopt;
+
+			return engine;
+		};
+
+		// report the smallest final state the match ended in
+		FSMResult simulate(std::string_view, FSM_MODE) const;
+		// report every final state the match ended in
+		FSMStateSetResult simulateStateSet(std::string_view, FSM_MODE) const;
+
+		size_t getClassCount() const { return m_ClassCount; };
+		size_t getWordCount() const { return m_WordCount; };
+	};
+
+
+	// IMPLEMENTATIONS
+	template <typename StepFn>
+	BitsetNFA::BitsetNFA(size_t stateCount, state_t startState, const SparseSet& start, const std::vector<bool>& isFinal, StepFn step) :
+		m_StateCount{ stateCount },
+		m_WordCount{ (stateCount + BLOCK_WORDS * 64 - 1) / (BLOCK_WORDS * 64) * BLOCK_WORDS },
+		m_StartState{ startState }
+	{
+		auto set = [](std::uint64_t* bits, state_t s) { bits[s / 64] |= std::uint64_t(1) << (s % 64); };
+
+		m_Start.assign(m_WordCount, 0);
+		for (state_t s : start)
+			set(m_Start.data(), s);
+
+		m_Final.assign(m_WordCount, 0);
+		for (state_t s = 0; s < stateCount; s++)
+			if (isFinal[s])
+				set(m_Final.data(), s);
+
+		/**
+		* The column of every byte, grouping equal columns into classes.
+		* The hash of a column sums a mix of each of its transitions, so it costs as much as setting their bits, whatever the width of the rows;
+		* a column is only compared word by word with the classes of the same hash.
+		*/
+		const size_t columnSize = stateCount * m_WordCount;
+		const size_t maxClassCount = MAX_ROW_BYTES / (columnSize * sizeof(std::uint64_t));
+		SparseSet targets(stateCount);
+		std::vector<std::uint64_t> column(columnSize);
+		std::vector<std::uint64_t> classHashes;
+
+		for (size_t b = 0; b < BYTE_COUNT; b++) {
+			std::fill(column.begin(), column.end(), 0);
+			std::uint64_t hash = 0;
+
+			for (state_t s = 0; s < stateCount; s++) {
+				step(s, (unsigned char)b, targets);
+				for (state_t t : targets) {
+					set(column.data() + s * m_WordCount, t);
+					hash += _mix(s * stateCount + t);
+				}
+			}
+
+			size_t cls = 0;
+			while (cls < m_ClassCount && (classHashes[cls] != hash || -not std::equal(column.begin(), column.end(), m_Rows.begin() + cls * columnSize)))
+				cls++;
+
+			if (cls == m_ClassCount) {
+				if (m_ClassCount == maxClassCount) {
+					m_Rows.clear();
+					m_ClassCount = 0;
+					return;
+				}
+
+				m_Rows.insert(m_Rows.end(), column.begin(), column.end());
+				classHashes.push_back(hash);
+				m_ClassCount++;
+			}
+
+			m_ByteClasses[b] = (byte_class_t)cls;
+		}
+	}
+
+	// the finalizer of splitmix64
+	inline std::uint64_t BitsetNFA::_mix(std::uint64_t x)
+	{
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+		return x ^ (x >> 31);
+	}
+
+	inline bool BitsetNFA::_any(const std::uint64_t* bits) const
+	{
+		for (size_t w = 0; w < m_WordCount; w++)
+			if (bits[w])
+				return true;
+
+		return false;
+	}
+
+	inline bool BitsetNFA::_any_final(const std::uint64_t* bits) const
+	{
+		for (size_t w = 0; w < m_WordCount; w++)
+			if (bits[w] & m_Final[w])
+				return true;
+
+		return false;
+	}
+
+	inline void BitsetNFA::_or(std::uint64_t* dest, const std::uint64_t* row) const
+	{
+#if FSM_BITSET_AVX2
+		for (size_t w = 0; w < m_WordCount; w += 4) {
+			__m256i acc = _mm256_loadu_si256((const __m256i*)(dest + w));
+			__m256i bits = _mm256_loadu_si256((const __m256i*)(row + w));
+			_mm256_storeu_si256((__m256i*)(dest + w), _mm256_or_si256(acc, bits));
+		}
+#elif FSM_BITSET_SSE2
+		for (size_t w = 0; w < m_WordCount; w += 2) {
+			__m128i acc = _mm_loadu_si128((const __m128i*)(dest + w));
+			__m128i bits = _mm_loadu_si128((const __m128i*)(row + w));
+			_mm_storeu_si128((__m128i*)(dest + w), _mm_or_si128(acc, bits));
+		}
+#else
+		for (size_t w = 0; w < m_WordCount; w++)
+			dest[w] |= row[w];
+#endif
+	}
+
+	inline void BitsetNFA::_step(const std::uint64_t* curr, unsigned char c, std::uint64_t* next) const
+	{
+		const std::uint64_t* rows = m_Rows.data() + m_ByteClasses[c] * m_StateCount * m_WordCount;
+		std::fill(next, next + m_WordCount, 0);
+
+		// OR the rows of the states in the set, visiting its bits from the lowest
+		for (size_t w = 0; w < m_WordCount; w++)
+			for (std::uint64_t word = curr[w]; word; word &= word - 1)
+				this->_or(next, rows + (w * 64 + std::countr_zero(word)) * m_WordCount);
+	}
+
+	inline state_set_t BitsetNFA::_get_final_states(const std::uint64_t* bits) const
+	{
+		state_set_t states;
+
+		for (size_t w = 0; w < m_WordCount; w++)
+			for (std::uint64_t word = bits[w] & m_Final[w]; word; word &= word - 1)
+				states.insert((state_t)(w * 64 + std::countr_zero(word)));
+
+		return states;
+	}
+
+	inline state_t BitsetNFA::_min_final_state(const std::uint64_t* bits) const
+	{
+		for (size_t w = 0; w < m_WordCount; w++)
+			if (std::uint64_t word = bits[w] & m_Final[w])
+				return (state_t)(w * 64 + std::countr_zero(word));
+
+		return m_StartState;
+	}
+
+	inline BitsetNFA::Match BitsetNFA::_match(size_t start, size_t end, const std::uint64_t* states) const
+	{
+		Match match{ true, start, end };
+
+		for (size_t w = 0; w < m_WordCount; w++)
+			match.finals[w] = states[w] & m_Final[w];
+
+		return match;
+	}
+
+	inline BitsetNFA::Match BitsetNFA::_simulate_whole_string(std::string_view input) const
+	{
+		Bits curr{}, next{};
+		std::copy(m_Start.begin(), m_Start.end(), curr.begin());
+
+		for (auto c : input) {
+			this->_step(curr.data(), (unsigned char)c, next.data());
+			std::swap(curr, next);
+
+			if (-not this->_any(curr.data()))
+				break;
+		}
+
+		if (-not this->_any_final(curr.data()))
+			return Match{};
+
+		return this->_match(0, input.size(), curr.data());
+	}
+
+	inline BitsetNFA::Match BitsetNFA::_simulate_longest_prefix(std::string_view input) const
+	{
+		Bits curr{}, next{};
+		std::copy(m_Start.begin(), m_Start.end(), curr.begin());
+		Match match;
+
+		// remember the final states of the last set that holds any
+		auto record = [&](size_t charCount) {
+			if (this->_any_final(curr.data()))
+				match = this->_match(0, charCount, curr.data());
+		};
+
+		record(0);
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+			this->_step(curr.data(), (unsigned char)input[charIndex], next.data());
+			std::swap(curr, next);
+
+			if (-not this->_any(curr.data()))
+				break;
+
+			record(charIndex + 1);
+		}
+
+		return match;
+	}
+
+	inline BitsetNFA::Match BitsetNFA::_simulate_longest_substring(std::string_view input) const
+	{
+		constexpr size_t NO_MATCH = (size_t)-1;
+
+		/**
+		* As in BitParallelNFA, the attempts that started at the same index form a group, the groups are disjoint and ordered by start index,
+		* and a state belongs to the group that started first.
+		* The bitsets of the groups are stored one after the other in `currSets` and `nextSets`, the i-th group owning the i-th bitset.
+		*/
+		const size_t W = m_WordCount;
+		std::vector<size_t> currStarts, nextStarts;
+		std::vector<std::uint64_t> currSets, nextSets((m_StateCount + 1) * W);
+		currStarts.reserve(m_StateCount + 1);
+		nextStarts.reserve(m_StateCount + 1);
+		currSets.reserve((m_StateCount + 1) * W);
+
+		// the states of all the current groups, and of the groups being built
+		std::vector<std::uint64_t> claimed(W), nextClaimed(W);
+
+		size_t matchStart = NO_MATCH, matchEnd = 0;
+		std::vector<std::uint64_t> matchStates(W);
+
+		for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+
+			// start a new attempt at this index with the states no earlier attempt holds, unless a match is already found
+			if (matchStart == NO_MATCH) {
+				const size_t offset = currSets.size();
+				bool any = false;
+
+				for (size_t w = 0; w < W; w++) {
+					currSets.push_back(m_Start[w] & ~claimed[w]);
+					any = any || currSets.back();
+				}
+
+				if (any)
+					currStarts.push_back(charIndex);
+				else
+					currSets.resize(offset);
+			}
+
+			nextStarts.clear();
+			std::fill(nextClaimed.begin(), nextClaimed.end(), 0);
+
+			for (size_t g = 0; g < currStarts.size(); g++) {
+				// attempts that started after the current match cannot replace it
+				if (currStarts[g] > matchStart && matchStart != NO_MATCH)
+					break;
+
+				std::uint64_t* states = nextSets.data() + nextStarts.size() * W;
+				this->_step(currSets.data() + g * W, (unsigned char)input[charIndex], states);
+
+				bool any = false;
+				for (size_t w = 0; w < W; w++) {
+					states[w] &= ~nextClaimed[w];
+					nextClaimed[w] |= states[w];
+					any = any || states[w];
+				}
+
+				if (any)
+					nextStarts.push_back(currStarts[g]);
+			}
+
+			// prefer the leftmost start, then the longest end; the first group holding a final state has the leftmost start
+			for (size_t g = 0; g < nextStarts.size(); g++) {
+				const std::uint64_t* states = nextSets.data() + g * W;
+				if (-not this->_any_final(states))
+					continue;
+
+				if (matchStart == NO_MATCH || nextStarts[g] <= matchStart) {
+					matchStart = nextStarts[g];
+					matchEnd = charIndex + 1;
+					std::copy(states, states + W, matchStates.begin());
+				}
+
+				break;
+			}
+
+			std::swap(currStarts, nextStarts);
+			currSets.assign(nextSets.begin(), nextSets.begin() + currStarts.size() * W);
+			std::swap(claimed, nextClaimed);
+
+			// no attempt can extend or replace the match
+			if (currStarts.empty() && matchStart != NO_MATCH)
+				break;
+		}
+
+		// if there was no accepted substring
+		if (matchStart == NO_MATCH)
+			return Match{};
+
+		return this->_match(matchStart, matchEnd, matchStates.data());
+	}
+
+	inline FSMResult BitsetNFA::simulate(std::string_view input, FSM_MODE mode) const
+	{
+		const Match match = this->_simulate(input, mode);
+		const state_t finalState = match.accepted ? this->_min_final_state(match.finals.data()) : m_StartState;
+
+		return FSMResult(match.accepted, finalState, { match.start, match.end }, input);
+	}
+
+	inline FSMStateSetResult BitsetNFA::simulateStateSet(std::string_view input, FSM_MODE mode) const
+	{
+		const Match match = this->_simulate(input, mode);
+		state_set_t finalStates = match.accepted ? this->_get_final_states(match.finals.data()) : state_set_t{ m_StartState };
+
+		return FSMStateSetResult(match.accepted, finalStates, { match.start, match.end }, input);
+	}
+
+	inline BitsetNFA::Match BitsetNFA::_simulate(std::string_view input, FSM_MODE mode) const
+	{
+		switch (mode) {
+		case FSM_MODE::MM_WHOLE_STRING:
+			return this->_simulate_whole_string(input);
+		case FSM_MODE::MM_LONGEST_PREFIX:
+			return this->_simulate_longest_prefix(input);
+		default:
+			return this->_simulate_longest_substring(input);
+		}
+	}
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "NFA.h"
+#include <algorithm>
+
+namespace m0st4fa {
+
+	// DECLARATIONS
+	/**
+	* @brief Return an NFA without epsilon transitions (MT_NON_EPSILON_NFA) that accepts the same strings as `nfa`, in every FSM_MODE.
+	* On a character, a state moves to the epsilon closures of the states that its own closure moves to,
+	* and a state is final if its closure holds a final state; the epsilon column ('\0') of the new table is empty.
+	* States that are unreachable from the start state, or that cannot reach a final state, are dropped.
+	* The start state keeps id 1, id 0 is left without transitions and the remaining states are renumbered in their original order,
+	* so the final states reported for a match are the new ids.
+	* A machine that is already free of epsilon transitions is returned as it is.
+	*/
+	template <typename TransFuncT, typename InputT>
+	NonDeterFiniteAutomatan<TransFuncT, InputT> removeEpsilonTransitions(const NonDeterFiniteAutomatan<TransFuncT, InputT>&);
+
+
+	// IMPLEMENTATIONS
+	template <typename TransFuncT, typename InputT>
+	NonDeterFiniteAutomatan<TransFuncT, InputT> removeEpsilonTransitions(const NonDeterFiniteAutomatan<TransFuncT, InputT>& nfa)
+	{
+		using TableT = decltype(TransFuncT{}.m_Function);
+		constexpr state_t START_STATE = 1;
+		constexpr state_t NO_STATE = (state_t)-1;
+
+		if (nfa.getMachineType() != FSM_TYPE::MT_EPSILON_NFA)
+			return nfa;
+
+		const TransFuncT& transFn = nfa.getTransitionFunction();
+		const state_set_t& finalStates = nfa.getFinalStates();
+		const size_t stateCount = std::max<size_t>(nfa.getStateCount(), START_STATE + 1);
+		const size_t inputMax = transFn.m_InputMax;
+
+		// a state is final if its closure holds a final state
+		std::vector<bool> isFinal(stateCount, false);
+		for (state_t s = 0; s < nfa.getStateCount(); s++)
+			for (state_t member : nfa.getEpsilonClosure(s))
+				if (finalStates.contains(member)) {
+					isFinal[s] = true;
+					break;
+				}
+
+		/**
+		* The rows of the new machine over the old ids, built for the states reachable from the start state only.
+		* `rows[s][in]` lists the states `s` moves to on `in`; the epsilon column 0 stays empty.
+		*/
+		std::vector<std::vector<std::vector<state_t>>> rows(stateCount);
+		std::vector<bool> reachable(stateCount, false);
+		std::vector<state_t> stack = { START_STATE };
+		reachable[START_STATE] = true;
+		SparseSet targets(stateCount);
+
+		while (stack.size()) {
+			state_t state = stack.back();
+			stack.pop_back();
+
+			auto& row = rows[state];
+			row.resize(inputMax);
+
+			for (size_t in = 1; in < inputMax; in++) {
+				targets.clear();
+
+				for (state_t p : nfa.getEpsilonClosure(state)) {
+					// states past the table have no transitions
+					if (p >= transFn.m_StateMax)
+						continue;
+
+					for (state_t t : transFn.entry(p, in))
+						for (state_t member : nfa.getEpsilonClosure(t))
+							targets.insert(member);
+				}
+
+				row[in].assign(targets.begin(), targets.end());
+				std::sort(row[in].begin(), row[in].end());
+
+				for (state_t next : row[in])
+					if (-not reachable[next]) {
+						reachable[next] = true;
+						stack.push_back(next);
+					}
+			}
+		}
+
+		// of the reachable states, keep those that can reach a final state (and the start state)
+		std::vector<std::vector<state_t>> predecessors(stateCount);
+		for (state_t s = 0; s < stateCount; s++)
+			if (reachable[s])
+				for (size_t in = 1; in < inputMax; in++)
+					for (state_t next : rows[s][in])
+						predecessors[next].push_back(s);
+
+		std::vector<bool> useful(stateCount, false);
+		for (state_t s = 0; s < stateCount; s++)
+			if (reachable[s] && isFinal[s]) {
+				useful[s] = true;
+				stack.push_back(s);
+			}
+
+		while (stack.size()) {
+			state_t state = stack.back();
+			stack.pop_back();
+
+			for (state_t prev : predecessors[state])
+				if (-not useful[prev]) {
+					useful[prev] = true;
+					stack.push_back(prev);
+				}
+		}
+
+		// renumber: the start state stays 1, id 0 has no transitions and the others follow in order
+		std::vector<state_t> idOf(stateCount, NO_STATE);
+		idOf[START_STATE] = START_STATE;
+		state_t nextId = START_STATE + 1;
+		for (state_t s = 0; s < stateCount; s++)
+			if (s != START_STATE && useful[s])
+				idOf[s] = nextId++;
+
+		/**
+		* A machine needs at least one final state; if none is reachable, add a final state that nothing moves to.
+		*/
+		state_set_t newFinalStates;
+		for (state_t s = 0; s < stateCount; s++)
+			if (useful[s] && isFinal[s])
+				newFinalStates.insert(idOf[s]);
+
+		if (newFinalStates.empty())
+			newFinalStates.insert(nextId++);
+
+		// build the table
+		const size_t newStateCount = nextId;
+		TableT table{};
+		if constexpr (std::is_constructible_v<TableT, size_t, size_t>)
+			table = TableT(newStateCount, inputMax);
+		else if (newStateCount > table.size())
+			throw std::length_error("removeEpsilonTransitions: the machine does not fit in the table type.");
+
+		for (state_t s = 0; s < stateCount; s++) {
+			if (idOf[s] == NO_STATE)
+				continue;
+
+			for (size_t in = 1; in < inputMax; in++) {
+				auto& entry = table[idOf[s]][in];
+
+				for (state_t next : rows[s][in])
+					if (idOf[next] != NO_STATE)
+						entry.insert(idOf[next]);
+			}
+		}
+
+		return NonDeterFiniteAutomatan<TransFuncT, InputT>{ newFinalStates, TransFuncT{ table }, FSM_TYPE::MT_NON_EPSILON_NFA, nfa.getFlags() };
+	}
+
+}
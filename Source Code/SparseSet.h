@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "FiniteStateMachine.h"
+
+namespace m0st4fa {
+
+	/**
+	* @brief A set of the states in [0, capacity), after Briggs and Torczon.
+	* `m_Dense` lists the members in insertion order and `m_Sparse[s]` is the position of `s` in it; `s` is a member exactly when the two agree,
+	* so neither array needs clearing: inserting, testing and clearing are O(1), iterating is O(size) and nothing is allocated after construction.
+	* This suits the sets of states an NFA simulation rebuilds on every character.
+	* States are not checked against the capacity.
+	*/
+	class SparseSet {
+		std::vector<state_t> m_Dense;
+		std::vector<state_t> m_Sparse;
+		size_t m_Size = 0;
+
+	public:
+		SparseSet() = default;
+		explicit SparseSet(size_t capacity) : m_Dense(capacity), m_Sparse(capacity) {};
+
+		bool contains(state_t state) const {
+			const state_t index = m_Sparse[state];
+			return index < m_Size && m_Dense[index] == state;
+		};
+
+		// returns whether the state was not a member yet
+		bool insert(state_t state) {
+			if (this->contains(state))
+				return false;
+
+			m_Dense[m_Size] = state;
+			m_Sparse[state] = (state_t)m_Size++;
+			return true;
+		};
+
+		void clear() { m_Size = 0; };
+
+		size_t size() const { return m_Size; };
+		bool empty() const { return m_Size == 0; };
+		size_t capacity() const { return m_Dense.size(); };
+
+		// the members in insertion order; inserting while iterating visits the new members too
+		const state_t* begin() const { return m_Dense.data(); };
+		const state_t* end() const { return m_Dense.data() + m_Size; };
+		state_t operator[](size_t index) const { return m_Dense[index]; };
+	};
+
+}
@@ -0,0 +1,917 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <string_view>
+#include <stdexcept>
+#include <cstdint>
+
+#include "FiniteStateMachine.h"
+#include "DFA.h"
+
+namespace m0st4fa {
+
+	namespace regex {
+
+		/**
+		* @brief A string literal that can be passed as a template argument, so that a pattern can be part of a type.
+		*/
+		template <size_t N>
+		struct FixedString {
+			char m_Data[N]{};
+
+			constexpr FixedString(const char (&str)[N]) {
+				for (size_t i = 0; i < N; i++)
+					m_Data[i] = str[i];
+			};
+
+			constexpr std::string_view view() const { return std::string_view{ m_Data, N - 1 }; };
+			constexpr size_t size() const { return N - 1; };
+		};
+
+		/**
+		* The compile-time pipeline behind StaticRegex: pattern -> syntax tree -> Thompson NFA -> subset construction -> Moore minimization.
+		* Everything here is constexpr and allocates only transiently, so it runs entirely inside the compiler.
+		* Errors are thrown; a throw cannot be evaluated at compile time, so a bad pattern fails the build with the message in the diagnostic.
+		*/
+		namespace detail {
+
+			constexpr size_t NONE = (size_t)-1;
+			constexpr size_t UNBOUNDED = (size_t)-1;
+			// guards against patterns whose DFA would exhaust the compiler
+			constexpr size_t MAX_DFA_STATES = 4096;
+			constexpr size_t MAX_REPETITION = 1024;
+
+			struct ByteSet {
+				std::uint64_t m_Bits[4]{};
+
+				constexpr void insert(unsigned char b) { m_Bits[b >> 6] |= std::uint64_t{ 1 } << (b & 63); };
+				constexpr void insertRange(unsigned char from, unsigned char to) {
+					for (unsigned b = from; b <= to; b++)
+						this->insert((unsigned char)b);
+				};
+				constexpr void erase(unsigned char b) { m_Bits[b >> 6] &= ~(std::uint64_t{ 1 } << (b & 63)); };
+				constexpr bool contains(unsigned char b) const { return (m_Bits[b >> 6] >> (b & 63)) & 1; };
+				constexpr bool empty() const { return -not (m_Bits[0] | m_Bits[1] | m_Bits[2] | m_Bits[3]); };
+				constexpr void invert() {
+					for (std::uint64_t& word : m_Bits)
+						word = ~word;
+				};
+				constexpr ByteSet& operator|=(const ByteSet& other) {
+					for (size_t i = 0; i < 4; i++)
+						m_Bits[i] |= other.m_Bits[i];
+					return *this;
+				};
+			};
+
+			enum class RE_NODE {
+				RN_EMPTY = 0,
+				RN_BYTES,
+				RN_CONCAT,
+				RN_ALTER,
+				RN_REPEAT,
+				RN_NODE_MAX,
+			};
+
+			struct Node {
+				RE_NODE type = RE_NODE::RN_EMPTY;
+				ByteSet bytes{};
+				size_t left = NONE, right = NONE;
+				size_t min = 0, max = 0;
+			};
+
+			/**
+			* @brief A recursive-descent parser for the pattern syntax:
+			* alternation `|`, grouping `( )`, the quantifiers `*`, `+`, `?`, `{n}`, `{n,}` and `{n,m}`,
+			* `.` (any byte but a newline), bracket classes `[a-z]` and `[^...]`, and the escapes
+			* \d \D \w \W \s \S \n \r \t \f \v \0 \xHH and a backslash before any punctuation.
+			* Anchors and lazy quantifiers are rejected: where a match may start and end is chosen by the FSM_MODE, and a DFA cannot be lazy.
+			*/
+			class PatternParser {
+				std::string_view m_Pattern;
+				size_t m_Index = 0;
+				std::vector<Node> m_Nodes;
+
+				constexpr bool _at_end() const { return m_Index == m_Pattern.size(); };
+				constexpr char _peek() const { return m_Pattern[m_Index]; };
+				constexpr size_t _push(const Node& node) { m_Nodes.push_back(node); return m_Nodes.size() - 1; };
+
+				constexpr size_t _alternation();
+				constexpr size_t _concatenation();
+				constexpr size_t _repetition();
+				constexpr size_t _atom();
+				constexpr ByteSet _class();
+				constexpr ByteSet _escape(bool& isSingle, unsigned char& single);
+				constexpr size_t _number();
+
+			public:
+				constexpr PatternParser(std::string_view pattern) : m_Pattern{ pattern } {};
+
+				// returns the root of the syntax tree; the nodes are left in `nodes`
+				constexpr size_t parse(std::vector<Node>& nodes);
+			};
+
+			struct NFAState {
+				ByteSet bytes{};
+				size_t next = NONE; // the target on `bytes`
+				std::vector<size_t> epsilon;
+			};
+
+			struct Fragment {
+				size_t start, end;
+			};
+
+			// the minimal DFA of a pattern; states are numbered with the dead state as 0 and the start state as 1, like every DFA here
+			struct CompiledPattern {
+				size_t stateCount = 0;
+				size_t classCount = 0;
+				ByteClassMap byteClasses{};
+				std::vector<state_t> table; // stateCount x classCount
+				std::vector<bool> finals;
+			};
+
+			constexpr CompiledPattern compilePattern(std::string_view pattern);
+
+			// the dimensions of the minimal DFA of a pattern
+			struct PatternShape {
+				size_t stateCount = 0;
+				size_t classCount = 0;
+			};
+
+			constexpr PatternShape patternShape(std::string_view pattern);
+
+			/**
+			* A CompiledPattern in arrays of exactly its dimensions, so it can be kept in a `static constexpr`.
+			* The dimensions must come from patternShape(): the vectors of a CompiledPattern cannot outlive constant evaluation,
+			* so the pattern is compiled once for its shape and once more into the arrays.
+			*/
+			template <size_t StateCount, size_t ClassCount>
+			struct FixedPattern {
+				std::array<state_t, StateCount * ClassCount> transitions{};
+				std::array<bool, StateCount> finals{};
+				ByteClassMap byteClasses{};
+			};
+
+			template <size_t StateCount, size_t ClassCount>
+			constexpr FixedPattern<StateCount, ClassCount> fixPattern(std::string_view pattern);
+
+		}
+
+		// DECLARATIONS
+		/**
+		* @brief A regular expression compiled to a minimal DFA by the compiler.
+		* The pattern is parsed, turned into an NFA, determinized and minimized during constant evaluation; a bad pattern is a compile error.
+		* The transition table is a `static constexpr` array, so it is emitted in read-only data and nothing is built at startup.
+		* simulate() follows the FSM_MODE semantics of DeterFiniteAutomatan::simulate() and is itself constexpr,
+		* so a match against a literal can be decided at compile time and small matchers inline into their callers.
+		*
+		* Usage:
+		*	using Identifier = StaticRegex<"[A-Za-z_][A-Za-z0-9_]*">;
+		*	static_assert(Identifier::match("snake_case"));
+		*	FSMResult res = Identifier::simulate(input, FSM_MODE::MM_LONGEST_PREFIX);
+		*/
+		template <FixedString Pattern>
+		class StaticRegex {
+			static constexpr state_t DEAD_STATE = 0;
+			static constexpr state_t START_STATE = 1;
+
+			// only read during constant evaluation, so it is not emitted
+			static constexpr detail::PatternShape SHAPE = detail::patternShape(Pattern.view());
+
+		public:
+			static constexpr size_t STATE_COUNT = SHAPE.stateCount;
+			static constexpr size_t CLASS_COUNT = SHAPE.classCount;
+
+		private:
+			using Tables = detail::FixedPattern<STATE_COUNT, CLASS_COUNT>;
+
+			static constexpr Tables TABLES = detail::fixPattern<STATE_COUNT, CLASS_COUNT>(Pattern.view());
+
+			static constexpr FSMResult _simulate_whole_string(std::string_view);
+			static constexpr FSMResult _simulate_longest_prefix(std::string_view);
+			static constexpr FSMResult _simulate_longest_substring(std::string_view);
+
+		public:
+			static constexpr std::string_view getPattern() { return Pattern.view(); };
+
+			static constexpr state_t nextState(state_t state, char c) {
+				return TABLES.transitions[state * CLASS_COUNT + TABLES.byteClasses[(unsigned char)c]];
+			};
+			static constexpr bool isFinal(state_t state) { return TABLES.finals[state]; };
+
+			static constexpr FSMResult simulate(std::string_view, FSM_MODE);
+			// whether the whole input matches the pattern
+			static constexpr bool match(std::string_view input) { return _simulate_whole_string(input).accepted; };
+
+			/**
+			* @brief Build a runtime DFA with the same states, for the APIs that take one (the lexer, batches, streaming, the serializer...).
+			*/
+			template <typename InputT = std::string>
+			static DFA<TransFn<FSMDynamicTable<state_t>>, InputT> toDFA();
+		};
+
+
+		// IMPLEMENTATIONS
+		namespace detail {
+
+			constexpr size_t PatternParser::parse(std::vector<Node>& nodes)
+			{
+				size_t root = this->_alternation();
+
+				if (-not this->_at_end())
+					throw std::invalid_argument("StaticRegex: unbalanced ')' in the pattern.");
+
+				nodes = std::move(m_Nodes);
+				return root;
+			}
+
+			constexpr size_t PatternParser::_alternation()
+			{
+				size_t left = this->_concatenation();
+
+				while (-not this->_at_end() && this->_peek() == '|') {
+					m_Index++;
+					size_t right = this->_concatenation();
+					left = this->_push(Node{ .type = RE_NODE::RN_ALTER, .left = left, .right = right });
+				}
+
+				return left;
+			}
+
+			constexpr size_t PatternParser::_concatenation()
+			{
+				size_t left = NONE;
+
+				while (-not this->_at_end() && this->_peek() != '|' && this->_peek() != ')') {
+					size_t right = this->_repetition();
+					left = left == NONE ? right : this->_push(Node{ .type = RE_NODE::RN_CONCAT, .left = left, .right = right });
+				}
+
+				// an empty branch, as in `a|` or `()`, matches the empty string
+				return left == NONE ? this->_push(Node{ .type = RE_NODE::RN_EMPTY }) : left;
+			}
+
+			constexpr size_t PatternParser::_repetition()
+			{
+				size_t atom = this->_atom();
+
+				while (-not this->_at_end()) {
+					size_t min = 0, max = UNBOUNDED;
+
+					switch (this->_peek()) {
+					case '*':
+						m_Index++;
+						break;
+					case '+':
+						m_Index++;
+						min = 1;
+						break;
+					case '?':
+						m_Index++;
+						max = 1;
+						break;
+					case '{':
+						m_Index++;
+						min = max = this->_number();
+
+						if (-not this->_at_end() && this->_peek() == ',') {
+							m_Index++;
+							max = -not this->_at_end() && this->_peek() == '}' ? UNBOUNDED : this->_number();
+						}
+
+						if (this->_at_end() || this->_peek() != '}')
+							throw std::invalid_argument("StaticRegex: a counted repetition is missing its '}'.");
+						m_Index++;
+
+						if (min > max)
+							throw std::invalid_argument("StaticRegex: a counted repetition {n,m} needs n <= m.");
+						if (min > MAX_REPETITION || (max != UNBOUNDED && max > MAX_REPETITION))
+							throw std::invalid_argument("StaticRegex: a counted repetition is too large.");
+						break;
+					default:
+						return atom;
+					}
+
+					if (-not this->_at_end() && this->_peek() == '?')
+						throw std::invalid_argument("StaticRegex: lazy quantifiers are not supported; a DFA always matches the longest input.");
+
+					atom = this->_push(Node{ .type = RE_NODE::RN_REPEAT, .left = atom, .min = min, .max = max });
+				}
+
+				return atom;
+			}
+
+			constexpr size_t PatternParser::_atom()
+			{
+				const char c = this->_peek();
+				m_Index++;
+
+				ByteSet bytes{};
+
+				switch (c) {
+				case '(': {
+					size_t inner = this->_alternation();
+
+					if (this->_at_end() || this->_peek() != ')')
+						throw std::invalid_argument("StaticRegex: unbalanced '(' in the pattern.");
+					m_Index++;
+
+					return inner;
+				}
+				case '[':
+					bytes = this->_class();
+					break;
+				case '.':
+					bytes.insertRange(0, 255);
+					bytes.erase('\n');
+					break;
+				case '\\': {
+					bool isSingle = false;
+					unsigned char single = 0;
+					bytes = this->_escape(isSingle, single);
+					break;
+				}
+				case '^':
+				case '$':
+					throw std::invalid_argument("StaticRegex: anchors are not supported; choose where a match may start and end with the FSM_MODE.");
+				case '*':
+				case '+':
+				case '?':
+				case '{':
+					throw std::invalid_argument("StaticRegex: a quantifier must follow something to repeat.");
+				default:
+					bytes.insert((unsigned char)c);
+				}
+
+				return this->_push(Node{ .type = RE_NODE::RN_BYTES, .bytes = bytes });
+			}
+
+			constexpr ByteSet PatternParser::_class()
+			{
+				ByteSet bytes{};
+				bool negated = false;
+
+				if (-not this->_at_end() && this->_peek() == '^') {
+					negated = true;
+					m_Index++;
+				}
+
+				// a ']' right after the opening bracket is a literal
+				bool first = true;
+
+				while (true) {
+					if (this->_at_end())
+						throw std::invalid_argument("StaticRegex: a bracket class is missing its ']'.");
+
+					char c = this->_peek();
+					m_Index++;
+
+					if (c == ']' && -not first)
+						break;
+					first = false;
+
+					// the lower end of a possible range
+					unsigned char from = (unsigned char)c;
+					if (c == '\\') {
+						bool isSingle = false;
+						ByteSet escaped = this->_escape(isSingle, from);
+
+						// a shorthand such as \d cannot be the end of a range
+						if (-not isSingle) {
+							bytes |= escaped;
+							continue;
+						}
+					}
+
+					// a '-' that is first, last or after a range is a literal
+					if (m_Index + 1 < m_Pattern.size() && this->_peek() == '-' && m_Pattern[m_Index + 1] != ']') {
+						m_Index++;
+						unsigned char to = (unsigned char)this->_peek();
+						m_Index++;
+
+						if (to == '\\') {
+							bool isSingle = false;
+							this->_escape(isSingle, to);
+
+							if (-not isSingle)
+								throw std::invalid_argument("StaticRegex: a shorthand class cannot end a range.");
+						}
+
+						if (from > to)
+							throw std::invalid_argument("StaticRegex: a range in a bracket class is out of order.");
+
+						bytes.insertRange(from, to);
+					}
+					else
+						bytes.insert(from);
+				}
+
+				if (negated)
+					bytes.invert();
+
+				return bytes;
+			}
+
+			/**
+			* @brief Parse the escape after a backslash; `isSingle` tells whether it stands for the single byte `single` or for a shorthand class.
+			*/
+			constexpr ByteSet PatternParser::_escape(bool& isSingle, unsigned char& single)
+			{
+				if (this->_at_end())
+					throw std::invalid_argument("StaticRegex: the pattern ends with a lone '\\'.");
+
+				const char c = this->_peek();
+				m_Index++;
+
+				ByteSet bytes{};
+				bool negated = false;
+				isSingle = false;
+
+				switch (c) {
+				case 'D':
+					negated = true;
+					[[fallthrough]];
+				case 'd':
+					bytes.insertRange('0', '9');
+					break;
+				case 'W':
+					negated = true;
+					[[fallthrough]];
+				case 'w':
+					bytes.insertRange('a', 'z');
+					bytes.insertRange('A', 'Z');
+					bytes.insertRange('0', '9');
+					bytes.insert('_');
+					break;
+				case 'S':
+					negated = true;
+					[[fallthrough]];
+				case 's':
+					for (char space : std::string_view{ " \t\n\r\f\v" })
+						bytes.insert((unsigned char)space);
+					break;
+				case 'n': isSingle = true; single = '\n'; break;
+				case 'r': isSingle = true; single = '\r'; break;
+				case 't': isSingle = true; single = '\t'; break;
+				case 'f': isSingle = true; single = '\f'; break;
+				case 'v': isSingle = true; single = '\v'; break;
+				case '0': isSingle = true; single = '\0'; break;
+				case 'x': {
+					unsigned value = 0;
+
+					for (size_t digit = 0; digit < 2; digit++, m_Index++) {
+						if (this->_at_end())
+							throw std::invalid_argument("StaticRegex: \\x needs two hexadecimal digits.");
+
+						char h = this->_peek();
+						if (h >= '0' && h <= '9')
+							value = value * 16 + (h - '0');
+						else if (h >= 'a' && h <= 'f')
+							value = value * 16 + (h - 'a' + 10);
+						else if (h >= 'A' && h <= 'F')
+							value = value * 16 + (h - 'A' + 10);
+						else
+							throw std::invalid_argument("StaticRegex: \\x needs two hexadecimal digits.");
+					}
+
+					isSingle = true;
+					single = (unsigned char)value;
+					break;
+				}
+				default:
+					// only punctuation may be escaped, so that a letter never silently means itself
+					if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9'))
+						throw std::invalid_argument("StaticRegex: unknown escape sequence in the pattern.");
+
+					isSingle = true;
+					single = (unsigned char)c;
+				}
+
+				if (isSingle)
+					bytes.insert(single);
+				if (negated)
+					bytes.invert();
+
+				return bytes;
+			}
+
+			constexpr size_t PatternParser::_number()
+			{
+				size_t value = 0, digits = 0;
+
+				while (-not this->_at_end() && this->_peek() >= '0' && this->_peek() <= '9' && digits < 8) {
+					value = value * 10 + (this->_peek() - '0');
+					m_Index++;
+					digits++;
+				}
+
+				if (digits == 0)
+					throw std::invalid_argument("StaticRegex: a counted repetition needs a number.");
+
+				return value;
+			}
+
+			// Thompson's construction; every call emits fresh states, so a repeated subtree is simply built again
+			constexpr Fragment buildNFA(const std::vector<Node>& nodes, size_t index, std::vector<NFAState>& states)
+			{
+				auto newState = [&states]() {
+					states.push_back(NFAState{});
+					return states.size() - 1;
+				};
+
+				const Node& node = nodes[index];
+
+				switch (node.type) {
+				case RE_NODE::RN_EMPTY: {
+					size_t state = newState();
+					return Fragment{ state, state };
+				}
+				case RE_NODE::RN_BYTES: {
+					size_t start = newState(), end = newState();
+					states[start].bytes = node.bytes;
+					states[start].next = end;
+					return Fragment{ start, end };
+				}
+				case RE_NODE::RN_CONCAT: {
+					Fragment left = buildNFA(nodes, node.left, states);
+					Fragment right = buildNFA(nodes, node.right, states);
+					states[left.end].epsilon.push_back(right.start);
+					return Fragment{ left.start, right.end };
+				}
+				case RE_NODE::RN_ALTER: {
+					size_t start = newState();
+					Fragment left = buildNFA(nodes, node.left, states);
+					Fragment right = buildNFA(nodes, node.right, states);
+					size_t end = newState();
+					states[start].epsilon.push_back(left.start);
+					states[start].epsilon.push_back(right.start);
+					states[left.end].epsilon.push_back(end);
+					states[right.end].epsilon.push_back(end);
+					return Fragment{ start, end };
+				}
+				case RE_NODE::RN_REPEAT: {
+					const size_t start = newState();
+					size_t curr = start;
+
+					// the required copies
+					for (size_t i = 0; i < node.min; i++) {
+						Fragment copy = buildNFA(nodes, node.left, states);
+						states[curr].epsilon.push_back(copy.start);
+						curr = copy.end;
+					}
+
+					if (node.max == UNBOUNDED) {
+						size_t loop = newState();
+						Fragment copy = buildNFA(nodes, node.left, states);
+						states[curr].epsilon.push_back(loop);
+						states[loop].epsilon.push_back(copy.start);
+						states[copy.end].epsilon.push_back(loop);
+						return Fragment{ start, loop };
+					}
+
+					// the optional copies, each of which may be skipped to the end
+					size_t end = newState();
+					for (size_t i = node.min; i < node.max; i++) {
+						Fragment copy = buildNFA(nodes, node.left, states);
+						states[curr].epsilon.push_back(copy.start);
+						states[curr].epsilon.push_back(end);
+						curr = copy.end;
+					}
+					states[curr].epsilon.push_back(end);
+
+					return Fragment{ start, end };
+				}
+				default:
+					throw std::logic_error("StaticRegex: unknown syntax tree node.");
+				}
+			}
+
+			constexpr CompiledPattern compilePattern(std::string_view pattern)
+			{
+				// parse and build the NFA
+				std::vector<Node> nodes;
+				size_t root = PatternParser{ pattern }.parse(nodes);
+
+				std::vector<NFAState> nfa;
+				Fragment whole = buildNFA(nodes, root, nfa);
+
+				CompiledPattern res;
+
+				// split the bytes into classes that no NFA transition tells apart
+				res.classCount = 1;
+				for (const NFAState& state : nfa) {
+					if (state.next == NONE)
+						continue;
+
+					std::vector<size_t> split(res.classCount * 2, NONE);
+					size_t count = 0;
+
+					for (size_t b = 0; b < BYTE_COUNT; b++) {
+						size_t& id = split[res.byteClasses[b] * 2 + state.bytes.contains((unsigned char)b)];
+						if (id == NONE)
+							id = count++;
+						res.byteClasses[b] = (byte_class_t)id;
+					}
+
+					res.classCount = count;
+				}
+
+				std::vector<unsigned char> representative(res.classCount);
+				for (size_t b = BYTE_COUNT; b-- > 0; )
+					representative[res.byteClasses[b]] = (unsigned char)b;
+
+				// subset construction; a DFA state is a sorted list of NFA states, and the empty list is the dead state
+				std::vector<std::vector<size_t>> subsets;
+				std::vector<size_t> dfaTable;
+
+				auto closure = [&](std::vector<size_t> seeds) {
+					std::vector<size_t> set;
+					std::vector<bool> inSet(nfa.size(), false);
+
+					while (-not seeds.empty()) {
+						size_t state = seeds.back();
+						seeds.pop_back();
+
+						if (inSet[state])
+							continue;
+						inSet[state] = true;
+						set.push_back(state);
+
+						for (size_t next : nfa[state].epsilon)
+							seeds.push_back(next);
+					}
+
+					std::sort(set.begin(), set.end());
+					return set;
+				};
+
+				auto find = [&subsets](const std::vector<size_t>& set) {
+					for (size_t i = 0; i < subsets.size(); i++)
+						if (subsets[i] == set)
+							return i;
+					return NONE;
+				};
+
+				subsets.push_back({});
+				subsets.push_back(closure({ whole.start }));
+
+				for (size_t curr = 0; curr < subsets.size(); curr++) {
+					for (size_t cls = 0; cls < res.classCount; cls++) {
+						std::vector<size_t> seeds;
+						for (size_t state : subsets[curr])
+							if (nfa[state].next != NONE && nfa[state].bytes.contains(representative[cls]))
+								seeds.push_back(nfa[state].next);
+
+						std::vector<size_t> target = closure(std::move(seeds));
+						size_t index = find(target);
+
+						if (index == NONE) {
+							if (subsets.size() == MAX_DFA_STATES)
+								throw std::invalid_argument("StaticRegex: the pattern needs too many DFA states.");
+
+							subsets.push_back(std::move(target));
+							index = subsets.size() - 1;
+						}
+
+						dfaTable.push_back(index);
+					}
+				}
+
+				const size_t dfaCount = subsets.size();
+				std::vector<bool> dfaFinal(dfaCount, false);
+				for (size_t i = 0; i < dfaCount; i++)
+					dfaFinal[i] = std::binary_search(subsets[i].begin(), subsets[i].end(), whole.end);
+
+				/**
+				* Moore's partition refinement: start from {non-final, final} and split blocks by the blocks of their targets until nothing changes.
+				* States that cannot reach a final state end up in the block of the dead state.
+				*/
+				std::vector<size_t> block(dfaCount);
+				for (size_t i = 0; i < dfaCount; i++)
+					block[i] = dfaFinal[i];
+				size_t blockCount = 0;
+
+				while (true) {
+					std::vector<size_t> newBlock(dfaCount, NONE), owners;
+
+					for (size_t s = 0; s < dfaCount; s++) {
+						for (size_t owner : owners) {
+							bool same = block[owner] == block[s];
+							for (size_t cls = 0; same && cls < res.classCount; cls++)
+								same = block[dfaTable[owner * res.classCount + cls]] == block[dfaTable[s * res.classCount + cls]];
+
+							if (same) {
+								newBlock[s] = newBlock[owner];
+								break;
+							}
+						}
+
+						if (newBlock[s] == NONE) {
+							newBlock[s] = owners.size();
+							owners.push_back(s);
+						}
+					}
+
+					block = std::move(newBlock);
+					if (owners.size() == blockCount)
+						break;
+					blockCount = owners.size();
+				}
+
+				if (block[1] == block[0])
+					throw std::invalid_argument("StaticRegex: the pattern cannot match anything.");
+
+				// number the blocks: the dead block is 0 and the start block is 1, as the automata expect
+				std::vector<state_t> id(blockCount, (state_t)NONE);
+				id[block[0]] = 0;
+				id[block[1]] = 1;
+				state_t nextId = 2;
+				for (size_t s = 0; s < dfaCount; s++)
+					if (id[block[s]] == (state_t)NONE)
+						id[block[s]] = nextId++;
+
+				res.stateCount = blockCount;
+				res.table.assign(blockCount * res.classCount, 0);
+				res.finals.assign(blockCount, false);
+
+				for (size_t s = 0; s < dfaCount; s++) {
+					const state_t state = id[block[s]];
+					res.finals[state] = dfaFinal[s];
+
+					for (size_t cls = 0; cls < res.classCount; cls++)
+						res.table[state * res.classCount + cls] = id[block[dfaTable[s * res.classCount + cls]]];
+				}
+
+				return res;
+			}
+
+			constexpr PatternShape patternShape(std::string_view pattern)
+			{
+				const CompiledPattern compiled = compilePattern(pattern);
+
+				return PatternShape{ compiled.stateCount, compiled.classCount };
+			}
+
+			template <size_t StateCount, size_t ClassCount>
+			constexpr FixedPattern<StateCount, ClassCount> fixPattern(std::string_view pattern)
+			{
+				const CompiledPattern compiled = compilePattern(pattern);
+
+				if (compiled.stateCount != StateCount || compiled.classCount != ClassCount)
+					throw std::logic_error("StaticRegex: the pattern compiled to a DFA of another shape.");
+
+				FixedPattern<StateCount, ClassCount> res;
+				res.byteClasses = compiled.byteClasses;
+
+				for (size_t i = 0; i < compiled.table.size(); i++)
+					res.transitions[i] = compiled.table[i];
+				for (size_t i = 0; i < compiled.stateCount; i++)
+					res.finals[i] = compiled.finals[i];
+
+				return res;
+			}
+
+		}
+
+		template <FixedString Pattern>
+		constexpr FSMResult StaticRegex<Pattern>::simulate(std::string_view input, FSM_MODE mode)
+		{
+			switch (mode) {
+			case FSM_MODE::MM_WHOLE_STRING:
+				return _simulate_whole_string(input);
+			case FSM_MODE::MM_LONGEST_PREFIX:
+				return _simulate_longest_prefix(input);
+			case FSM_MODE::MM_LONGEST_SUBSTRING:
+				return _simulate_longest_substring(input);
+			default:
+				throw std::runtime_error("The provided mode is erroneous in function StaticRegex::simulate().");
+			}
+		}
+
+		template <FixedString Pattern>
+		constexpr FSMResult StaticRegex<Pattern>::_simulate_whole_string(std::string_view input)
+		{
+			state_t currState = START_STATE;
+
+			for (size_t charIndex = 0; charIndex < input.size() && currState != DEAD_STATE; charIndex++)
+				currState = nextState(currState, input[charIndex]);
+
+			bool accepted = isFinal(currState);
+
+			return FSMResult(accepted, accepted ? currState : START_STATE, { 0, accepted ? input.size() : 0 }, input);
+		}
+
+		template <FixedString Pattern>
+		constexpr FSMResult StaticRegex<Pattern>::_simulate_longest_prefix(std::string_view input)
+		{
+			state_t currState = START_STATE, lastFinalState = START_STATE;
+			size_t lastFinalIndex = 0;
+
+			for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+				currState = nextState(currState, input[charIndex]);
+
+				if (currState == DEAD_STATE)
+					break;
+
+				if (isFinal(currState)) {
+					lastFinalState = currState;
+					lastFinalIndex = charIndex + 1;
+				}
+			}
+
+			bool accepted = lastFinalIndex > 0;
+
+			return FSMResult(accepted, accepted ? lastFinalState : START_STATE, { 0, lastFinalIndex }, input);
+		}
+
+		/**
+		* The leftmost-longest search of DeterFiniteAutomatan::_simulate_longest_substring().
+		* An attempt owns the states it reaches, so there are never more attempts than states and fixed arrays suffice.
+		*/
+		template <FixedString Pattern>
+		constexpr FSMResult StaticRegex<Pattern>::_simulate_longest_substring(std::string_view input)
+		{
+			constexpr size_t NO_MATCH = (size_t)-1;
+
+			struct Attempt {
+				state_t state = DEAD_STATE;
+				size_t start = 0;
+			};
+
+			std::array<Attempt, STATE_COUNT> attempts[2]{};
+			std::array<size_t, STATE_COUNT> claimed{};
+			size_t counts[2] = { 0, 0 }, generation = 1;
+			size_t curr = 0;
+
+			size_t matchStart = NO_MATCH, matchEnd = 0;
+			state_t matchState = START_STATE;
+
+			for (size_t charIndex = 0; charIndex < input.size(); charIndex++) {
+				// start a new attempt at this index, unless a match is already found (a later attempt cannot be leftmost)
+				if (matchStart == NO_MATCH && claimed[START_STATE] != generation) {
+					claimed[START_STATE] = generation;
+					attempts[curr][counts[curr]++] = Attempt{ START_STATE, charIndex };
+				}
+
+				generation++;
+				counts[1 - curr] = 0;
+
+				for (size_t a = 0; a < counts[curr]; a++) {
+					const Attempt attempt = attempts[curr][a];
+
+					// attempts that started after the current match cannot replace it
+					if (matchStart != NO_MATCH && attempt.start > matchStart)
+						break;
+
+					state_t state = nextState(attempt.state, input[charIndex]);
+
+					// the attempt dies or is merged into an attempt that started earlier
+					if (state == DEAD_STATE || claimed[state] == generation)
+						continue;
+
+					claimed[state] = generation;
+					attempts[1 - curr][counts[1 - curr]++] = Attempt{ state, attempt.start };
+
+					// prefer the leftmost start, then the longest end
+					if (isFinal(state) && (matchStart == NO_MATCH || attempt.start <= matchStart)) {
+						matchStart = attempt.start;
+						matchEnd = charIndex + 1;
+						matchState = state;
+					}
+				}
+
+				curr = 1 - curr;
+
+				// no attempt can extend or replace the match
+				if (counts[curr] == 0 && matchStart != NO_MATCH)
+					break;
+			}
+
+			if (matchStart == NO_MATCH)
+				return FSMResult(false, START_STATE, { 0, 0 }, input);
+
+			return FSMResult(true, matchState, { matchStart, matchEnd }, input);
+		}
+
+		template <FixedString Pattern>
+		template <typename InputT>
+		DFA<TransFn<FSMDynamicTable<state_t>>, InputT> StaticRegex<Pattern>::toDFA()
+		{
+			FSMDynamicTable<state_t> table{ STATE_COUNT, BYTE_COUNT };
+			state_set_t finalStates;
+
+			for (state_t state = 0; state < STATE_COUNT; state++) {
+				if (isFinal(state))
+					finalStates.insert(state);
+
+				for (size_t b = 0; b < BYTE_COUNT; b++)
+					table[state][b] = nextState(state, (char)b);
+			}
+
+			return DFA<TransFn<FSMDynamicTable<state_t>>, InputT>{ finalStates, TransFn<FSMDynamicTable<state_t>>{ table } };
+		}
+
+	}
+
+}
@@ -3,6 +3,7 @@ module;
 #include <string>
 #include <iostream>
 #include <map>
+#include <random>
 
 #include "FiniteStateMachine.h"
 #include "Parser.h"
@@ -48,6 +49,24 @@ constexpr void initTranFn_ab_NFA(T& fun) {
 
 };
 
+/**
+* Fill rows [1, stateCount) of `fun` with random moves on 'a', 'b' and 'c', and on '\0' too if `epsilon`.
+* The same seed always gives the same machine, so that a failing check can be replayed.
+*/
+export template<typename T>
+void initTranFn_random_NFA(T& fun, size_t stateCount, unsigned seed, bool epsilon) {
+	std::mt19937 rng{ seed };
+
+	for (size_t s = 1; s < stateCount; s++) {
+		for (char c : { 'a', 'b', 'c' })
+			for (size_t k = rng() % 3; k > 0; k--)
+				fun[s][c].insert((state_t)(rng() % stateCount));
+
+		if (epsilon && rng() % 4 == 0)
+			fun[s]['\0'].insert((state_t)(rng() % stateCount));
+	}
+};
+
 export enum TOKEN {
 	T_AAB,
 	T_EOF,
@@ -1,6 +1,12 @@
 // std includes
 #include <iostream>
 #include <array>
+#include <random>
+#include <tuple>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <cstddef>
 
 // my includes
 #include "regex.h"
@@ -10,6 +16,16 @@
 #include "LLPGenerator.h"
 #include "LRPGenerator.h"
 #include "LexicalAnalyzer.h"
+#include "DFACodeGenerator.h"
+#include "DFASerializer.h"
+#include "DFAStreamMatcher.h"
+#include "DFAMinimizer.h"
+#include "DFAJit.h"
+#include "MappedFile.h"
+#include "StaticRegex.h"
+#include "GeneratedDFAs.h"
+#include "NFA.h"
+#include "NFAEpsilonEliminator.h"
 #include "ANSI.h"
 
 import Tests;
@@ -463,5 +479,699 @@ int main(void) {
 	}
 }
 
+#elif defined TEST_FSM_REGRESSIONS
+
+// written by DFAGenerator in the pre-build step
+#include "Generated/ab_dfa.h"
+
+/**
+* Regression checks for the matchers: every check prints whether it passed, and the program exits with the number of checks that failed.
+* The machines are the ab machines of the other tests, a few small hand-written machines and random machines from fixed seeds.
+*/
+using m0st4fa::FSMResult;
+using m0st4fa::FSM_MODE;
+using m0st4fa::FSM_TYPE;
+using m0st4fa::FSM_EXEC_MODE;
+using m0st4fa::FSMDynamicTable;
+using m0st4fa::BYTE_COUNT;
+using m0st4fa::DFAStreamMatcher;
+using m0st4fa::DFASerializer;
+using m0st4fa::DFAAccelerator;
+using m0st4fa::DFAJit;
+using m0st4fa::NFA;
+using m0st4fa::BitParallelNFA;
+using m0st4fa::SparseSet;
+using m0st4fa::regex::StaticRegex;
+
+using dfa_table_t = std::array<std::array<state_t, 'z'>, 10>;
+using ab_dfa_t = DFA<TransitionFunction<dfa_table_t>>;
+using dynamic_dfa_t = DFA<TransitionFunction<FSMDynamicTable<state_t>>>;
+using nfa_table_t = FSMDynamicTable<state_set_t>;
+using random_nfa_t = NFA<TransitionFunction<nfa_table_t>>;
+
+static constexpr FSM_MODE ALL_MODES[] = { FSM_MODE::MM_WHOLE_STRING, FSM_MODE::MM_LONGEST_PREFIX, FSM_MODE::MM_LONGEST_SUBSTRING };
+
+static int failures = 0;
+
+static void check(const std::string& name, bool passed) {
+	std::cout << (passed ? "[PASS] " : "[FAIL] ") << name << "\n";
+
+	if (-not passed)
+		failures++;
+}
+
+static bool sameResult(const FSMResult& lhs, const FSMResult& rhs) {
+	return lhs.accepted == rhs.accepted && lhs.finalState == rhs.finalState &&
+		lhs.indecies.start == rhs.indecies.start && lhs.indecies.end == rhs.indecies.end;
+}
+
+// the same match, whatever the final state is called
+static bool sameMatch(const FSMResult& lhs, const FSMResult& rhs) {
+	return lhs.accepted == rhs.accepted && lhs.indecies.start == rhs.indecies.start && lhs.indecies.end == rhs.indecies.end;
+}
+
+static bool sameResults(const std::vector<FSMResult>& lhs, const std::vector<FSMResult>& rhs) {
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), sameResult);
+}
+
+static std::string randomInput(std::mt19937& rng, const std::string& alphabet, size_t maxLength) {
+	std::string input(rng() % (maxLength + 1), ' ');
+
+	for (char& c : input)
+		c = alphabet[rng() % alphabet.size()];
+
+	return input;
+}
+
+// long runs of a filler byte, broken by the bytes on which the quote and comment machines leave their loops
+static std::string runsInput(std::mt19937& rng, size_t pieces) {
+	static const std::string BREAKS = "\"#\n" "\xe9" "a";
+	std::string input;
+
+	for (size_t p = 0; p < pieces; p++)
+		if (rng() % 3 == 0)
+			input.append(rng() % 100, 'x');
+		else
+			input += BREAKS[rng() % BREAKS.size()];
+
+	return input;
+}
+
+static ab_dfa_t abDFA() {
+	dfa_table_t table{};
+	initTranFn_ab(table);
+
+	return ab_dfa_t{ state_set_t{ 4 }, TransitionFunction<dfa_table_t>{ table } };
+}
+
+// a DFA over "abc" whose states move to random states, the dead state included
+static dynamic_dfa_t randomDFA(std::mt19937& rng, size_t stateCount) {
+	FSMDynamicTable<state_t> table{ stateCount, 'z' };
+	state_set_t finalStates{ (state_t)stateCount - 1 };
+
+	for (state_t s = 1; s < stateCount; s++) {
+		for (char c : { 'a', 'b', 'c' })
+			table[s][c] = (state_t)(rng() % stateCount);
+
+		if (rng() % 4 == 0)
+			finalStates.insert(s);
+	}
+
+	return dynamic_dfa_t{ finalStates, TransitionFunction<FSMDynamicTable<state_t>>{ table } };
+}
+
+// a double-quoted string: inside the quotes, the machine stays where it is on every byte but the closing quote
+static dynamic_dfa_t quoteDFA() {
+	FSMDynamicTable<state_t> table{ 4, BYTE_COUNT };
+
+	table[1]['"'] = 2;
+	for (size_t b = 0; b < BYTE_COUNT; b++)
+		table[2][b] = 2;
+	table[2]['"'] = 3;
+	table[3]['"'] = 2;
+
+	return dynamic_dfa_t{ state_set_t{ 3 }, TransitionFunction<FSMDynamicTable<state_t>>{ table } };
+}
+
+// a '#' comment up to the end of the line: inside it, the machine stays where it is on every ASCII byte but '\0' and '\n'
+static dynamic_dfa_t commentDFA() {
+	FSMDynamicTable<state_t> table{ 4, BYTE_COUNT };
+
+	table[1]['#'] = 2;
+	for (size_t b = 1; b < 0x80; b++)
+		table[2][b] = 2;
+	table[2]['\n'] = 3;
+
+	return dynamic_dfa_t{ state_set_t{ 2, 3 }, TransitionFunction<FSMDynamicTable<state_t>>{ table } };
+}
+
+// counts the characters modulo `n`, accepting multiples of `n`; every state lives and `a` permutes them
+static dynamic_dfa_t counterDFA(size_t n) {
+	FSMDynamicTable<state_t> table{ n + 1, 'z' };
+
+	for (state_t s = 1; s <= n; s++)
+		table[s]['a'] = (state_t)(s % n + 1);
+
+	return dynamic_dfa_t{ state_set_t{ 1 }, TransitionFunction<FSMDynamicTable<state_t>>{ table } };
+}
+
+// tracks the parities of the `a`s and the `b`s, accepting when both are even; `x` is skipped
+static dynamic_dfa_t parityDFA() {
+	FSMDynamicTable<state_t> table{ 5, 'z' };
+
+	for (state_t s = 1; s <= 4; s++) {
+		table[s]['a'] = (state_t)((s - 1) ^ 2) + 1;
+		table[s]['b'] = (state_t)((s - 1) ^ 1) + 1;
+		table[s]['x'] = s;
+	}
+
+	return dynamic_dfa_t{ state_set_t{ 1 }, TransitionFunction<FSMDynamicTable<state_t>>{ table } };
+}
+
+// the leftmost match, as the longest accepted prefix at the first offset that has one; the start state of the machines here is not final
+template <typename AutomatonT>
+static FSMResult leftmostLongest(const AutomatonT& automaton, const std::string& input) {
+	for (size_t start = 0; start < input.size(); start++) {
+		FSMResult res = automaton.simulate(input.substr(start), FSM_MODE::MM_LONGEST_PREFIX);
+
+		// the span is relative to the offset the prefix starts at
+		if (res.accepted) {
+			res.indecies.start += start;
+			res.indecies.end += start;
+			return res;
+		}
+	}
+
+	return FSMResult(false, { 1 }, { 0, 0 }, input);
+}
+
+// the matches of findAll(), as leftmost-longest searches that each resume at the end of the previous match
+template <typename AutomatonT>
+static std::vector<FSMResult> findAllByScan(const AutomatonT& automaton, std::string_view input) {
+	std::vector<FSMResult> matches;
+
+	for (size_t pos = 0; pos < input.size(); ) {
+		FSMResult res = automaton.simulate(input.substr(pos), FSM_MODE::MM_LONGEST_SUBSTRING);
+
+		if (-not res.accepted)
+			break;
+
+		matches.push_back(FSMResult(true, res.finalState, { pos + res.indecies.start, pos + res.indecies.end }, input));
+		pos += res.indecies.end;
+	}
+
+	return matches;
+}
+
+static void testLeftmostLongestSubstring() {
+	ab_dfa_t dfa = abDFA();
+
+	// matches start at the leftmost offset that has one and run as far as they can, even through a shorter match: { input, accepted, start, end }
+	const std::vector<std::tuple<std::string, bool, size_t, size_t>> cases = {
+		{ "aaababffaba", true, 0, 6 },
+		{ "xaab", true, 1, 4 },
+		{ "abaab", true, 2, 5 },
+		{ "aabb", true, 0, 3 },
+		{ "ababab", false, 0, 0 },
+	};
+
+	bool passed = true;
+	for (const auto& [input, accepted, start, end] : cases) {
+		FSMResult res = dfa.simulate(input, FSM_MODE::MM_LONGEST_SUBSTRING);
+		passed = passed && res.accepted == accepted && res.indecies.start == start && res.indecies.end == end;
+	}
+	check("DFA leftmost-longest substring on fixed inputs", passed);
+
+	std::mt19937 rng{ 1 };
+	passed = true;
+	for (size_t i = 0; i < 2000 && passed; i++) {
+		std::string input = randomInput(rng, "aabx", 24);
+		passed = sameResult(dfa.simulate(input, FSM_MODE::MM_LONGEST_SUBSTRING), leftmostLongest(dfa, input));
+	}
+	check("DFA leftmost-longest substring against a scan of every start", passed);
+
+	passed = true;
+	for (unsigned seed = 1; seed <= 20 && passed; seed++) {
+		nfa_table_t table{ 12, 'z' };
+		initTranFn_random_NFA(table, 12, seed, false);
+		random_nfa_t nfa{ state_set_t{ 5, 9 }, TransitionFunction<nfa_table_t>{ table }, FSM_TYPE::MT_NON_EPSILON_NFA };
+
+		for (size_t i = 0; i < 200 && passed; i++) {
+			std::string input = randomInput(rng, "abcx", 24);
+			passed = sameResult(nfa.simulate(input, FSM_MODE::MM_LONGEST_SUBSTRING), leftmostLongest(nfa, input));
+		}
+	}
+	check("NFA leftmost-longest substring against a scan of every start", passed);
+}
+
+static void testExecModes() {
+	std::mt19937 rng{ 5 };
+
+	// the class table holds 1, 2 and 4-byte entries at these sizes
+	for (size_t stateCount : { 5, 14, 300, 20000 }) {
+		bool passed = true;
+
+		for (size_t m = 0; m < 5 && passed; m++) {
+			dynamic_dfa_t dfa = randomDFA(rng, stateCount);
+
+			for (size_t i = 0; i < 200 && passed; i++) {
+				std::string input = randomInput(rng, "abcx", 40);
+
+				for (FSM_MODE mode : ALL_MODES)
+					passed = passed && sameResult(dfa.simulate(input, mode, FSM_EXEC_MODE::EM_PREMULTIPLIED), dfa.simulate(input, mode, FSM_EXEC_MODE::EM_CHECKED));
+			}
+		}
+
+		check("premultiplied and checked runs agree at " + std::to_string(stateCount) + " states", passed);
+	}
+}
+
+static void testBatch() {
+	std::mt19937 rng{ 7 };
+	dynamic_dfa_t dfa = randomDFA(rng, 30);
+	bool passed = true;
+
+	// every batch size up to a few rounds of lanes, so that the lanes run out of inputs at different times
+	for (size_t count = 0; count <= 20 && passed; count++) {
+		std::vector<std::string> inputs(count);
+		for (std::string& input : inputs)
+			input = randomInput(rng, "abcx", 40);
+		const std::vector<std::string_view> views(inputs.begin(), inputs.end());
+
+		for (FSM_MODE mode : ALL_MODES) {
+			std::vector<FSMResult> results(count), viewResults(count);
+			dfa.simulate(std::span<const std::string>{ inputs }, mode, std::span<FSMResult>{ results });
+			dfa.simulate(std::span<const std::string_view>{ views }, mode, std::span<FSMResult>{ viewResults });
+
+			for (size_t i = 0; i < count; i++) {
+				const FSMResult expected = dfa.simulate(inputs[i], mode);
+
+				passed = passed && sameResult(results[i], expected) && sameResult(viewResults[i], expected) &&
+					sameResult(dfa.simulate(std::as_bytes(std::span<const char>{ inputs[i] }), mode), expected);
+			}
+		}
+	}
+
+	check("batches, views and bytes match like one string at a time", passed);
+}
+
+static void testMinimize() {
+	std::mt19937 rng{ 8 };
+	bool passed = true;
+
+	for (size_t m = 0; m < 20 && passed; m++) {
+		dynamic_dfa_t dfa = randomDFA(rng, 3 + m * 2);
+		auto minimal = m0st4fa::minimize(dfa);
+
+		for (size_t i = 0; i < 200 && passed; i++) {
+			std::string input = randomInput(rng, "abcx", 30);
+
+			for (FSM_MODE mode : ALL_MODES)
+				passed = passed && sameMatch(minimal.simulate(input, mode), dfa.simulate(input, mode));
+		}
+
+		// a minimal machine has nothing left to merge
+		passed = passed && m0st4fa::minimize(minimal).getTransitionFunction().m_StateMax == minimal.getTransitionFunction().m_StateMax;
+	}
+	check("minimized DFAs match what the originals match", passed);
+
+	// the ab machine with a twin for each of states 2 to 5, entered instead of the original in some places; every twin merges with its original
+	FSMDynamicTable<state_t> table{ 6, 'z' }, twins{ 11, 'z' };
+	initTranFn_ab(table);
+	initTranFn_ab(twins);
+	for (state_t s = 2; s <= 5; s++)
+		for (size_t c = 0; c < 'z'; c++)
+			twins[s + 5][c] = twins[s][c];
+	twins[1]['a'] = 7;
+	twins[4]['a'] = 8;
+	twins[4]['b'] = 10;
+
+	const auto minimalAB = m0st4fa::minimize(dynamic_dfa_t{ state_set_t{ 4 }, TransitionFunction<FSMDynamicTable<state_t>>{ table } });
+	const auto minimalTwins = m0st4fa::minimize(dynamic_dfa_t{ state_set_t{ 4, 9 }, TransitionFunction<FSMDynamicTable<state_t>>{ twins } });
+
+	passed = minimalTwins.getTransitionFunction().m_StateMax == minimalAB.getTransitionFunction().m_StateMax;
+	for (size_t i = 0; i < 500 && passed; i++) {
+		std::string input = randomInput(rng, "aabx", 24);
+
+		for (FSM_MODE mode : ALL_MODES)
+			passed = passed && sameMatch(minimalTwins.simulate(input, mode), minimalAB.simulate(input, mode));
+	}
+	check("minimize() merges equivalent states", passed);
+}
+
+static void testAccelerators() {
+	std::mt19937 rng{ 9 };
+	bool passed = true;
+
+	for (const dynamic_dfa_t& dfa : { quoteDFA(), commentDFA() })
+		for (size_t i = 0; i < 1000 && passed; i++) {
+			std::string input = runsInput(rng, 30);
+
+			for (FSM_MODE mode : ALL_MODES)
+				passed = passed && sameResult(dfa.simulate(input, mode, FSM_EXEC_MODE::EM_PREMULTIPLIED), dfa.simulate(input, mode, FSM_EXEC_MODE::EM_CHECKED));
+		}
+
+	check("accelerated runs agree with byte-at-a-time runs", passed);
+}
+
+static void testStreamChunks() {
+	ab_dfa_t dfa = abDFA();
+	std::mt19937 rng{ 2 };
+	bool passed = true;
+
+	for (size_t i = 0; i < 300 && passed; i++) {
+		std::string input = randomInput(rng, "aabx", 20);
+
+		for (FSM_MODE mode : ALL_MODES) {
+			const FSMResult expected = dfa.simulate(input, mode);
+
+			// split once at every offset, then feed a byte at a time
+			for (size_t split = 0; split <= input.size(); split++) {
+				DFAStreamMatcher<TransitionFunction<dfa_table_t>> matcher{ dfa, mode };
+				matcher.feed(std::string_view{ input }.substr(0, split));
+				matcher.feed(std::string_view{ input }.substr(split));
+				passed = passed && sameResult(matcher.finish(), expected);
+			}
+
+			DFAStreamMatcher<TransitionFunction<dfa_table_t>> matcher{ dfa, mode };
+			for (size_t c = 0; c < input.size(); c++)
+				matcher.feed(std::string_view{ input }.substr(c, 1));
+			passed = passed && sameResult(matcher.finish(), expected);
+		}
+	}
+
+	check("matches split across feed() chunks", passed);
+}
+
+static void testMappedFiles() {
+	const std::string path = (std::filesystem::temp_directory_path() / "fsm_regressions.txt").string();
+	ab_dfa_t dfa = abDFA();
+	std::mt19937 rng{ 13 };
+	bool passed = true, scanned = true;
+
+	for (size_t i = 0; i < 50 && passed && scanned; i++) {
+		// the first file is empty, and an empty file maps to no memory at all
+		const std::string contents = i == 0 ? "" : randomInput(rng, "aabx", 3000);
+		std::ofstream{ path, std::ios::binary } << contents;
+
+		for (FSM_MODE mode : ALL_MODES)
+			passed = passed && sameResult(m0st4fa::simulateFile(dfa, path, mode), dfa.simulate(contents, mode));
+		passed = passed && sameResults(m0st4fa::findAllInFile(dfa, path), dfa.findAll(contents));
+
+		scanned = sameResults(dfa.findAll(contents), findAllByScan(dfa, contents));
+	}
+
+	std::filesystem::remove(path);
+	check("files mapped in place match like strings", passed);
+	check("findAll() resumes every search at the end of the previous match", scanned);
+}
+
+static void testParallelSimulate() {
+	bool passed = true;
+
+	/**
+	* The lookback window permutes the seven live states of the counter, so a chunk has seven candidate start states, too many to run from each:
+	* it is run from the guess, which is the same for every chunk. The chunks start in different states unless the chunk size is a multiple of 7,
+	* so for most of the lengths here a guess is wrong and its chunk is re-run.
+	*/
+	dynamic_dfa_t counter = counterDFA(7);
+	for (size_t length = 3000; length < 3021 && passed; length++) {
+		const std::string input(length, 'a');
+
+		passed = dynamic_dfa_t::parallelChunkCount(length, 3, 1000) == 3 &&
+			sameResult(counter.simulateParallel(input, 3, 1000), counter.simulate(input, FSM_MODE::MM_WHOLE_STRING));
+	}
+	check("parallel simulate() re-runs the chunks it guessed wrong", passed);
+
+	// the four states of the parity machine are few enough to run every chunk from each of them
+	dynamic_dfa_t parity = parityDFA();
+	std::mt19937 rng{ 14 };
+	passed = true;
+	for (size_t i = 0; i < 50 && passed; i++) {
+		const std::string input = randomInput(rng, "abx", 8000);
+
+		for (size_t threads = 2; threads <= 8 && passed; threads++)
+			passed = sameResult(parity.simulateParallel(input, threads, 500), parity.simulate(input, FSM_MODE::MM_WHOLE_STRING));
+	}
+	check("parallel simulate() composes the chunks it ran from every candidate", passed);
+}
+
+static void testParallelFindAll() {
+	ab_dfa_t dfa = abDFA();
+	std::mt19937 rng{ 3 };
+
+	// runs of "aaab" form one long match, so the chunk edges fall inside matches as well as between them
+	std::string input;
+	while (input.size() < 20000) {
+		for (size_t r = rng() % 40; r > 0; r--)
+			input += "aaab";
+		input += randomInput(rng, "abx", 6);
+	}
+
+	const std::vector<FSMResult> expected = dfa.findAll(input);
+	bool passed = expected.size() > 0;
+
+	for (size_t threads = 2; threads <= 9 && passed; threads++)
+		passed = ab_dfa_t::parallelChunkCount(input.size(), threads, 1000) == threads && sameResults(dfa.findAllParallel(input, threads, 1000), expected);
+
+	check("parallel findAll stitching at chunk edges", passed);
+}
+
+static void testSerializer() {
+	const std::string path = (std::filesystem::temp_directory_path() / "fsm_regressions.dfa").string();
+	const std::string corruptPath = (std::filesystem::temp_directory_path() / "fsm_regressions_corrupt.dfa").string();
+	std::mt19937 rng{ 16 };
+	bool passed = true;
+
+	for (const dynamic_dfa_t& dfa : { quoteDFA(), commentDFA(), randomDFA(rng, 40) }) {
+		DFASerializer::save(dfa, path);
+		const auto loaded = DFASerializer::load(path);
+
+		for (size_t i = 0; i < 300 && passed; i++) {
+			std::string input = runsInput(rng, 10) + randomInput(rng, "abc", 20);
+
+			for (FSM_MODE mode : ALL_MODES)
+				passed = passed && sameResult(loaded.simulate(input, mode), dfa.simulate(input, mode));
+		}
+	}
+	check("saved DFAs load with the same matches", passed);
+
+	// corrupt one field of a good file at a time; the offsets are those of the fields of DFASerializer::Header
+	DFASerializer::save(quoteDFA(), path);
+	std::ifstream file{ path, std::ios::binary };
+	const std::string bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	file.close();
+
+	auto sectionStart = [&bytes](size_t headerOffset) {
+		std::uint64_t offset = 0;
+		std::memcpy(&offset, bytes.data() + headerOffset, sizeof(offset));
+		return (size_t)offset;
+	};
+	auto rejects = [&bytes, &corruptPath](size_t offset, auto value) {
+		std::string corrupt = bytes;
+		std::memcpy(corrupt.data() + offset, &value, sizeof(value));
+		std::ofstream{ corruptPath, std::ios::binary } << corrupt;
+
+		try {
+			DFASerializer::load(corruptPath);
+			return false;
+		}
+		catch (const std::runtime_error&) {
+			return true;
+		}
+	};
+
+	constexpr size_t ROW_COUNT = 56, FINAL_STATES = 128, STATE_IDS = 176, ACCELERATORS = 192;
+	check("load() rejects a file with too many rows", rejects(ROW_COUNT, (std::uint64_t)1 << 60));
+	check("load() rejects a row with the id of a state that does not exist", rejects(sectionStart(STATE_IDS), (state_t)1000));
+	check("load() rejects a final state that does not exist", rejects(sectionStart(FINAL_STATES), (state_t)1000));
+	check("load() rejects an accelerator flag that is neither 0 nor 1", rejects(sectionStart(ACCELERATORS) + offsetof(DFAAccelerator, exitsOnHighBytes), (std::uint8_t)2));
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(corruptPath);
+}
+
+static void testGeneratedMatcher() {
+	auto entry = std::find_if(m0st4fa::GENERATED_DFAS.begin(), m0st4fa::GENERATED_DFAS.end(), [](const auto& dfa) { return dfa.name == "ab_dfa"; });
+	bool passed = entry != m0st4fa::GENERATED_DFAS.end();
+
+	std::mt19937 rng{ 17 };
+	for (size_t i = 0; i < 2000 && passed; i++) {
+		std::string input = randomInput(rng, "aabx", 24);
+
+		for (FSM_MODE mode : ALL_MODES) {
+			const FSMResult expected = entry->build().simulate(input, mode);
+			const ab_dfa::Result res = ab_dfa::match(input, (ab_dfa::Mode)mode);
+
+			passed = passed && res.accepted == expected.accepted && res.finalState == expected.finalState &&
+				res.start == expected.indecies.start && res.end == expected.indecies.end;
+		}
+	}
+
+	check("generated matcher agrees with the DFA it was generated from", passed);
+}
+
+using Identifier = StaticRegex<"[A-Za-z_][A-Za-z0-9_]*">;
+using Number = StaticRegex<"-?[0-9]+(\\.[0-9]+)?">;
+using Keyword = StaticRegex<"if|else|while">;
+
+static_assert(Identifier::match("snake_case") && -not Identifier::match("9lives"));
+static_assert(Number::simulate("x = -12.5;", FSM_MODE::MM_LONGEST_SUBSTRING).indecies.start == 4);
+static_assert(Number::simulate("x = -12.5;", FSM_MODE::MM_LONGEST_SUBSTRING).indecies.end == 9);
+static_assert(Keyword::simulate("whileelse", FSM_MODE::MM_LONGEST_PREFIX).indecies.end == 5);
+
+template <typename RegexT>
+static bool agreesWithDFA(std::mt19937& rng, const std::string& alphabet) {
+	const auto dfa = RegexT::toDFA();
+
+	for (size_t i = 0; i < 1000; i++) {
+		std::string input = randomInput(rng, alphabet, 20);
+
+		for (FSM_MODE mode : ALL_MODES)
+			if (-not sameResult(RegexT::simulate(input, mode), dfa.simulate(input, mode)))
+				return false;
+	}
+
+	return true;
+}
+
+static void testStaticRegex() {
+	std::mt19937 rng{ 18 };
+
+	check("StaticRegex agrees with its runtime DFA", agreesWithDFA<Identifier>(rng, "aZ_9 ") &&
+		agreesWithDFA<Number>(rng, "-1.9 ") && agreesWithDFA<Keyword>(rng, "ifelswh"));
+}
+
+static void testJit() {
+	std::mt19937 rng{ 19 };
+	bool passed = true;
+
+	for (const dynamic_dfa_t& dfa : { quoteDFA(), commentDFA(), randomDFA(rng, 30), randomDFA(rng, 300) }) {
+		DFAJit<TransitionFunction<FSMDynamicTable<state_t>>> jit{ dfa };
+
+		for (size_t i = 0; i < 500 && passed; i++) {
+			std::string input = runsInput(rng, 10) + randomInput(rng, "abc", 30);
+
+			for (FSM_MODE mode : ALL_MODES)
+				passed = passed && sameResult(jit.simulate(input, mode), dfa.simulate(input, mode));
+		}
+	}
+
+	check("JIT code agrees with simulate()", passed);
+}
+
+static void testEpsilonElimination() {
+	std::mt19937 rng{ 23 };
+	bool passed = true;
+
+	for (size_t stateCount : { 12, 40 })
+		for (unsigned seed = 1; seed <= 10 && passed; seed++) {
+			nfa_table_t table{ stateCount, 'z' };
+			initTranFn_random_NFA(table, stateCount, seed, true);
+			random_nfa_t nfa{ state_set_t{ 5, (state_t)stateCount - 1 }, TransitionFunction<nfa_table_t>{ table }, FSM_TYPE::MT_EPSILON_NFA };
+			random_nfa_t eliminated = m0st4fa::removeEpsilonTransitions(nfa);
+
+			passed = eliminated.getMachineType() == FSM_TYPE::MT_NON_EPSILON_NFA;
+			for (size_t i = 0; i < 200 && passed; i++) {
+				std::string input = randomInput(rng, "abcx", 24);
+
+				// the states are renumbered, so only the matches are compared
+				for (FSM_MODE mode : ALL_MODES)
+					passed = passed && sameMatch(eliminated.simulate(input, mode), nfa.simulate(input, mode));
+			}
+		}
+
+	check("epsilon-free NFAs match what the originals match", passed);
+}
+
+static void testNFAEngines() {
+	// the padded machine has the same moves but more rows than any bit-parallel engine holds, so it is simulated over SparseSets
+	constexpr size_t PADDED_ROWS = 1100;
+	std::mt19937 rng{ 4 };
+
+	for (size_t stateCount : { 64, 65, 128, 129, 256, 257, 1024 }) {
+		bool passed = true;
+
+		for (unsigned seed = 1; seed <= 6 && passed; seed++) {
+			const bool epsilon = seed % 2 == 0;
+			nfa_table_t table{ stateCount, 'z' }, padded{ PADDED_ROWS, 'z' };
+			initTranFn_random_NFA(table, stateCount, seed, epsilon);
+			initTranFn_random_NFA(padded, stateCount, seed, epsilon);
+
+			state_set_t finalStates;
+			for (state_t s = 2; s < stateCount; s++)
+				if (rng() % (stateCount / 8 + 2) == 0)
+					finalStates.insert(s);
+			finalStates.insert((state_t)stateCount - 1);
+
+			const FSM_TYPE type = epsilon ? FSM_TYPE::MT_EPSILON_NFA : FSM_TYPE::MT_NON_EPSILON_NFA;
+			random_nfa_t nfa{ finalStates, TransitionFunction<nfa_table_t>{ table }, type };
+			random_nfa_t reference{ finalStates, TransitionFunction<nfa_table_t>{ padded }, type };
+			passed = nfa.isBitParallel() && -not reference.isBitParallel();
+
+			for (size_t i = 0; i < 100 && passed; i++) {
+				std::string input = randomInput(rng, "abcx", 30);
+
+				for (FSM_MODE mode : ALL_MODES) {
+					const auto states = nfa.simulateStateSet(input, mode), expectedStates = reference.simulateStateSet(input, mode);
+
+					passed = passed && sameResult(nfa.simulate(input, mode), reference.simulate(input, mode)) &&
+						states.accepted == expectedStates.accepted && states.finalStates == expectedStates.finalStates &&
+						states.indecies.start == expectedStates.indecies.start && states.indecies.end == expectedStates.indecies.end;
+				}
+			}
+		}
+
+		check("NFA engines agree with SparseSets at " + std::to_string(stateCount) + " states", passed);
+	}
+}
+
+static void testShiftAnd() {
+	constexpr size_t PADDED_ROWS = 1100;
+	std::mt19937 rng{ 24 };
+	bool detected = true, passed = true;
+
+	// a chain over "abc", in which every state moves only to the next one, on one to three of the letters
+	for (size_t stateCount : { 10, 64, 65, 200 }) {
+		nfa_table_t table{ stateCount, 'z' }, padded{ PADDED_ROWS, 'z' };
+		for (state_t s = 1; s + 1 < stateCount; s++)
+			for (size_t k = 1 + rng() % 3; k > 0; k--) {
+				const char c = "abc"[rng() % 3];
+				table[s][c] = padded[s][c] = state_set_t{ s + 1 };
+			}
+
+		auto step = [&table](state_t state, unsigned char c, SparseSet& out) {
+			out.clear();
+			if (c < 'z')
+				for (state_t target : table[state][c])
+					out.insert(target);
+		};
+		SparseSet start{ stateCount };
+		start.insert(1);
+		std::vector<bool> isFinal(stateCount, false);
+		isFinal[stateCount - 1] = true;
+
+		if (stateCount <= 64)
+			detected = detected && BitParallelNFA<1>{ stateCount, 1, start, isFinal, step }.isShiftAnd();
+		else
+			detected = detected && BitParallelNFA<4>{ stateCount, 1, start, isFinal, step }.isShiftAnd();
+
+		random_nfa_t nfa{ state_set_t{ (state_t)stateCount - 1 }, TransitionFunction<nfa_table_t>{ table }, FSM_TYPE::MT_NON_EPSILON_NFA };
+		random_nfa_t reference{ state_set_t{ (state_t)stateCount - 1 }, TransitionFunction<nfa_table_t>{ padded }, FSM_TYPE::MT_NON_EPSILON_NFA };
+
+		for (size_t i = 0; i < 300 && passed; i++) {
+			std::string input = randomInput(rng, i % 2 ? "abc" : "abcx", stateCount + 10);
+
+			for (FSM_MODE mode : ALL_MODES)
+				passed = passed && sameResult(nfa.simulate(input, mode), reference.simulate(input, mode));
+		}
+	}
+
+	check("chain-shaped NFAs take the Shift-And step", detected);
+	check("Shift-And steps agree with SparseSets", passed);
+}
+
+int main(void) {
+	testLeftmostLongestSubstring();
+	testExecModes();
+	testBatch();
+	testMinimize();
+	testAccelerators();
+	testStreamChunks();
+	testMappedFiles();
+	testParallelSimulate();
+	testParallelFindAll();
+	testSerializer();
+	testGeneratedMatcher();
+	testStaticRegex();
+	testJit();
+	testEpsilonElimination();
+	testNFAEngines();
+	testShiftAnd();
+
+	std::cout << failures << " check(s) failed\n";
+	return failures;
+}
+
 #endif
 
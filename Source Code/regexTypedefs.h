@@ -6,17 +6,16 @@
 namespace m0st4fa {
 
 	namespace regex {
-		constexpr size_t STATE_COUNT = 100;
+		// the width of the transition tables built for patterns; the number of states is decided when the pattern is compiled
 		constexpr size_t INPUT_COUNT = 128;
 		using index_t = unsigned int;
 
-		// TODO: change FSMTable to be an API implementation around vectors
 		using AttributeType = size_t;
 		using TokenType = Token<Terminal, AttributeType>;
 		using InputType = std::string;
 		using TokenFactType = TokenFactoryT<TokenType, InputType>;
 
-		using DFATableType = FSMTable<STATE_COUNT, INPUT_COUNT>;
+		using DFATableType = FSMDynamicTable<state_t>;
 		using TransFnType = TransFn<DFATableType>;
 		using DFAType = DFA<TransFnType, InputType>;
 